@@ -144,6 +144,28 @@ class pandamonium_common
       }
   }
 
+  static quint64 hash(const QByteArray &bytes)
+  {
+    /*
+    ** FNV-1a followed by MurmurHash3's finalizer. Not cryptographic.
+    */
+
+    quint64 h = Q_UINT64_C(14695981039346656037);
+
+    for(int i = 0; i < bytes.length(); i++)
+      {
+	h ^= static_cast<quint8> (bytes.at(i));
+	h *= Q_UINT64_C(1099511628211);
+      }
+
+    h ^= h >> 33;
+    h *= Q_UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+  }
+
   static const int pandamonium_home_maximum_length = 256;
   static const qint64 maximum_database_size = static_cast<qint64>
     (2147483648LL);
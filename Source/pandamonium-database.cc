@@ -25,139 +25,327 @@
 ** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <QCryptographicHash>
 #include <QDateTime>
+#include <QSet>
+#include <QSettings>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QThreadStorage>
 #include <QUrl>
 #include <QtDebug>
 
+#include <math.h>
+
 #include "pandamonium-common.h"
 #include "pandamonium-database.h"
 
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC) || defined(Q_OS_UNIX)
+extern "C"
+{
+#include <sys/stat.h>
+}
+#endif
+
+/*
+** Connections are cached per thread and per database file. A QSqlDatabase
+** may only be used by the thread which created it.
+*/
+
+class pandamonium_database_connections
+{
+ public:
+  pandamonium_database_connections(void)
+  {
+  }
+
+  ~pandamonium_database_connections()
+  {
+    foreach(const QString &fileName, m_names.keys())
+      close(fileName);
+  }
+
+  QHash<QString, QHash<QString, QSqlQuery> > m_queries;
+  QHash<QString, QString> m_names;
+  QHash<QString, int> m_transactions;
+  QHash<QString, quint64> m_generations;
+
+  void close(const QString &fileName)
+  {
+    m_generations.remove(fileName);
+    m_queries.remove(fileName);
+    m_transactions.remove(fileName);
+
+    QString name(m_names.take(fileName));
+
+    if(name.isEmpty())
+      return;
+
+    {
+      QSqlDatabase db(QSqlDatabase::database(name, false));
+
+      db.close();
+    }
+
+    QSqlDatabase::removeDatabase(name);
+  }
+};
+
+static QThreadStorage<pandamonium_database_connections *> s_connections;
+
+QAtomicInt pandamonium_database::s_automaticCheckpoints(1);
+QHash<QString, qint64> pandamonium_database::s_identities;
+QHash<QString, quint64> pandamonium_database::s_generations;
 QReadWriteLock pandamonium_database::s_dbIdLock;
+QReadWriteLock pandamonium_database::s_generationsLock;
 quint64 pandamonium_database::s_dbId = 0;
 
+static pandamonium_database_connections *connections(void)
+{
+  if(!s_connections.hasLocalData())
+    s_connections.setLocalData(new pandamonium_database_connections());
+
+  return s_connections.localData();
+}
+
 QHash<QString, QString> pandamonium_database::exportDefinition(void)
 {
   QHash<QString, QString> hash;
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_export_definition.db"));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_export_definition.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+      query.setForwardOnly(true);
 
-	query.setForwardOnly(true);
+      if(query.exec("SELECT * FROM pandamonium_export_definition"))
+	if(query.next())
+	  for(int i = 0; i < query.record().count(); i++)
+	    hash[query.record().fieldName(i)] =
+	      query.value(i).toString();
+    }
 
-	if(query.exec("SELECT * FROM pandamonium_export_definition"))
-	  if(query.next())
-	    for(int i = 0; i < query.record().count(); i++)
-	      hash[query.record().fieldName(i)] =
-		query.value(i).toString();
-      }
+  return hash;
+}
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+QHash<QString, quint64> pandamonium_database::counters(void)
+{
+  QHash<QString, quint64> hash;
+  QSqlDatabase db(connection("pandamonium_statistics.db"));
+
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.setForwardOnly(true);
+
+      if(query.exec("SELECT name, value FROM pandamonium_counters"))
+	while(query.next())
+	  hash[query.value(0).toString()] =
+	    query.value(1).toULongLong();
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
   return hash;
 }
 
-QList<QList<QVariant> > pandamonium_database::parsedLinks(const quint64 limit,
-							  const quint64 offset)
+QList<QList<QVariant> > pandamonium_database::depthStatistics(void)
 {
   QList<QList<QVariant> > list;
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_statistics.db"));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_parsed_urls.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-    if(pair.first.open())
+      query.setForwardOnly(true);
+
+      if(query.exec("SELECT depth, discovered, fetched "
+		    "FROM pandamonium_depth_statistics ORDER BY depth"))
+	while(query.next())
+	  {
+	    QList<QVariant> values;
+
+	    values << query.value(0).toInt();
+	    values << query.value(1).toULongLong();
+	    values << query.value(2).toULongLong();
+	    list << values;
+	  }
+    }
+
+  return list;
+}
+
+QList<QList<QVariant> > pandamonium_database::dueUrls
+(const qint64 now, QPair<qint64, qint64> &cursor, const int limit)
+{
+  QList<QList<QVariant> > list;
+
+  /*
+  ** Parsed URLs whose revisits are due, the stalest first. The cursor,
+  ** (time_due, rowid), excludes URLs which were issued earlier. Their
+  ** revisits move time_due beyond the cursor. The validators of the
+  ** URLs accompany them so that their fetches need not read them.
+  */
+
+  QSqlQuery query
+    (preparedQuery("pandamonium_parsed_urls.db",
+		   "SELECT etag, last_modified, rowid, time_due, url "
+		   "FROM pandamonium_parsed_urls "
+		   "WHERE time_due <= ? AND "
+		   "(time_due > ? OR (time_due = ? AND rowid > ?)) "
+		   "ORDER BY time_due, rowid LIMIT ?"));
+  QSqlQuery depth
+    (preparedQuery("pandamonium_visited_urls.db",
+		   "SELECT depth, seed FROM pandamonium_visited_urls "
+		   "WHERE url_hash = ? AND url = ?"));
+
+  query.bindValue(0, now);
+  query.bindValue(1, cursor.first);
+  query.bindValue(2, cursor.first);
+  query.bindValue(3, cursor.second);
+  query.bindValue(4, qMax(1, limit));
+
+  if(query.exec())
+    while(query.next())
       {
-	QSqlQuery query(pair.first);
+	QUrl url(QUrl::fromEncoded(query.value(4).toByteArray()));
 
-	/*
-	** Oh no! Not a parameter.
-	*/
+	cursor.first = query.value(3).toLongLong();
+	cursor.second = query.value(2).toLongLong();
 
-	query.setForwardOnly(true);
-	query.prepare
-	  (QString("SELECT title, url FROM pandamonium_parsed_urls "
-		   "ORDER BY time_inserted DESC LIMIT %1 OFFSET %2").
-	   arg(limit).
-	   arg(offset));
+	if(url.isEmpty() || !url.isValid())
+	  continue;
 
-	if(query.exec())
-	  while(query.next())
-	    {
-	      QUrl url(QUrl::fromEncoded(query.value(1).toByteArray()));
+	QList<QVariant> values; /*
+				** 0 - url
+				** 1 - depth
+				** 2 - etag
+				** 3 - last_modified
+				** 4 - seed
+				*/
+	qint64 seed = 0;
 
-	      if(!url.isEmpty())
-		if(url.isValid())
-		  {
-		    QList<QVariant> values;
+	depth.bindValue(0, urlHash(query.value(4).toByteArray()));
+	depth.bindValue(1, query.value(4).toByteArray());
 
-		    values << query.value(0).toString() << url;
-		    list << values;
-		  }
-	    }
+	if(depth.exec() && depth.next())
+	  {
+	    values << url << depth.value(0).toInt();
+	    seed = depth.value(1).toLongLong();
+	  }
+	else
+	  values << url << -1; // Compacted or unknown.
+
+	depth.finish();
+	values << query.value(0).toByteArray()
+	       << query.value(1).toByteArray()
+	       << seed;
+	list << values;
       }
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  query.finish();
+  return list;
+}
+
+QList<QList<QVariant> > pandamonium_database::parsedLinks(const quint64 limit,
+							  const quint64 offset)
+{
+  QList<QList<QVariant> > list;
+  QSqlDatabase db(connection("pandamonium_parsed_urls.db"));
+
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      /*
+      ** Oh no! Not a parameter.
+      */
+
+      query.setForwardOnly(true);
+      query.prepare
+	(QString("SELECT title, url FROM pandamonium_parsed_urls "
+		 "ORDER BY time_inserted DESC LIMIT %1 OFFSET %2").
+	 arg(limit).
+	 arg(offset));
+
+      if(query.exec())
+	while(query.next())
+	  {
+	    QUrl url(QUrl::fromEncoded(query.value(1).toByteArray()));
+
+	    if(!url.isEmpty())
+	      if(url.isValid())
+		{
+		  QList<QVariant> values;
+
+		  values << query.value(0).toString() << url;
+		  list << values;
+		}
+	  }
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
   return list;
 }
 
 QList<QList<QVariant> > pandamonium_database::searchUrls(void)
 {
   QList<QList<QVariant> > list;
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_search_urls.db"));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+      query.setForwardOnly(true);
 
-	query.setForwardOnly(true);
+      if(query.exec("SELECT concurrency, head_only, meta_data_only, "
+		    "paused, request_interval, search_depth, url "
+		    "FROM pandamonium_search_urls"))
+	while(query.next())
+	  {
+	    QList<QVariant> values;
+
+	    values << query.value(0).toInt();
+	    values << query.value(1).toInt();
+	    values << query.value(2).toInt();
+	    values << query.value(3).toInt();
+	    values << query.value(4).toDouble();
+	    values << query.value(5).toInt();
+	    values << QUrl::fromEncoded(query.value(6).toByteArray());
+	    list << values;
+	  }
+    }
 
-	if(query.exec("SELECT paused, request_interval, search_depth, url "
-		      "FROM pandamonium_search_urls"))
-	  while(query.next())
-	    {
-	      QList<QVariant> values;
+  return list;
+}
 
-	      values << query.value(0).toInt();
-	      values << query.value(1).toDouble();
-	      values << query.value(2).toInt();
-	      values << QUrl::fromEncoded(query.value(3).toByteArray());
-	      list << values;
-	    }
-      }
+QList<QList<QVariant> > pandamonium_database::visitedUrls(const int limit)
+{
+  QList<QList<QVariant> > list;
+  QSqlQuery query
+    (preparedQuery("pandamonium_visited_urls.db",
+		   "SELECT rowid, url, depth FROM pandamonium_visited_urls "
+		   "WHERE visited = 1 LIMIT ?"));
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  query.bindValue(0, qMax(1, limit));
 
-  QSqlDatabase::removeDatabase(pair.second);
+  if(query.exec())
+    while(query.next())
+      {
+	QList<QVariant> values; /*
+				** 0 - rowid
+				** 1 - url
+				** 2 - depth
+				*/
+
+	values << query.value(0).toLongLong()
+	       << query.value(1).toByteArray()
+	       << query.value(2).toInt();
+	list << values;
+      }
+
+  query.finish();
   return list;
 }
 
@@ -176,284 +364,695 @@ QPair<QSqlDatabase, QString> pandamonium_database::database(void)
   return pair;
 }
 
-QPair<quint64, quint64> pandamonium_database::unvisitedAndVisitedNumbers(void)
+QString pandamonium_database::absoluteFileName(const QString &fileName)
 {
-  QPair<QSqlDatabase, QString> pair;
-  QPair<quint64, quint64> numbers;
+  if(QFileInfo(fileName).isAbsolute())
+    return fileName;
+  else
+    return pandamonium_common::homePath() + QDir::separator() + fileName;
+}
+
+QStringList pandamonium_database::fileNames(void)
+{
+  QStringList list;
+
+  list << "pandamonium_broken_urls.db"
+       << "pandamonium_export_definition.db"
+       << "pandamonium_kernel_command.db"
+       << "pandamonium_parsed_urls.db"
+       << "pandamonium_search_urls.db"
+       << "pandamonium_statistics.db"
+       << "pandamonium_visited_urls.db";
+  return list;
+}
+
+QStringList pandamonium_database::pragmas(void)
+{
+  /*
+  ** Per-connection settings. Please see pandamonium.ini.
+  */
+
+  QSettings settings;
+  QString synchronous
+    (settings.value("pandamonium_sqlite_synchronous", "NORMAL").
+     toString().toUpper().trimmed());
+  QStringList list;
+
+  if(!(synchronous == "FULL" ||
+       synchronous == "NORMAL" ||
+       synchronous == "OFF"))
+    synchronous = "NORMAL";
+
+  list << QString("PRAGMA cache_size = -%1").
+    arg(qBound(256,
+	       settings.value("pandamonium_sqlite_cache_size", 16384).toInt(),
+	       1048576)) // KiB.
+       << QString("PRAGMA mmap_size = %1").
+    arg(qBound(static_cast<qint64> (0),
+	       settings.value("pandamonium_sqlite_mmap_size", 268435456).
+	       toLongLong(),
+	       static_cast<qint64> (4294967296LL))) // Bytes.
+       << "PRAGMA recursive_triggers = ON" // REPLACE fires DELETE triggers.
+       << QString("PRAGMA synchronous = %1").arg(synchronous);
+
+  if(s_automaticCheckpoints.fetchAndAddOrdered(0))
+    list << QString("PRAGMA wal_autocheckpoint = %1").
+      arg(qBound(0,
+		 settings.value("pandamonium_sqlite_wal_autocheckpoint",
+				1000).toInt(),
+		 1000000)); // Pages.
+  else
+    list << "PRAGMA wal_autocheckpoint = 0";
+
+  return list;
+}
+
+QSqlDatabase pandamonium_database::connection(const QString &fileName)
+{
+  QString path(absoluteFileName(fileName));
+  pandamonium_database_connections *c = connections();
+  quint64 g = generation(path);
+
+  if(c->m_names.contains(path))
+    {
+      if(c->m_generations.value(path) == g)
+	return QSqlDatabase::database(c->m_names.value(path), true);
+
+      /*
+      ** The database was invalidated.
+      */
+
+      c->close(path);
+    }
+
+  QString name("");
+  quint64 dbId = 0;
 
   {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_visited_urls.db");
+    QWriteLocker locker(&s_dbIdLock);
 
-    if(pair.first.open())
+    dbId = s_dbId += 1;
+  }
+
+  name = QString("database_%1").arg(dbId);
+
+  {
+    QSqlDatabase db(QSqlDatabase::addDatabase("QSQLITE", name));
+
+    db.setDatabaseName(path);
+
+    if(db.open())
       {
-	QSqlQuery query(pair.first);
+	QSqlQuery query(db);
 
-	query.setForwardOnly(true);
+	foreach(const QString &pragma, pragmas())
+	  query.exec(pragma);
 
-	if(query.exec("SELECT COUNT(*), 'u' FROM pandamonium_visited_urls "
-		      "WHERE visited = 0 UNION "
-		      "SELECT COUNT(*), 'v' FROM pandamonium_visited_urls "
-		      "WHERE visited = 1 ORDER BY 2"))
-	  {
-	    query.next();
+	c->m_generations[path] = g;
+	c->m_names[path] = name;
+
+	QWriteLocker locker(&s_generationsLock);
+
+	if(!s_identities.contains(path))
+	  s_identities[path] = identity(path);
+
+	return db;
+      }
+  }
+
+  QSqlDatabase::removeDatabase(name);
+  return QSqlDatabase();
+}
+
+QSqlQuery pandamonium_database::preparedQuery(const QString &fileName,
+					      const QString &statement)
+{
+  QSqlDatabase db(connection(fileName));
+
+  if(!db.isOpen())
+    return QSqlQuery(db);
+
+  QHash<QString, QSqlQuery> &queries
+    (connections()->m_queries[absoluteFileName(fileName)]);
+
+  if(!queries.contains(statement))
+    {
+      QSqlQuery query(db);
+
+      query.setForwardOnly(true);
+
+      if(!query.prepare(statement))
+	return query;
+
+      queries[statement] = query;
+    }
+
+  return queries.value(statement);
+}
+
+QPair<quint64, quint64> pandamonium_database::unvisitedAndVisitedNumbers(void)
+{
+  QPair<quint64, quint64> numbers(visitedUrlsCounts());
+
+  /*
+  ** Visited URLs which were compacted into the URL store.
+  */
+
+  numbers.second += counters().value("url_store_urls");
+  return numbers;
+}
+
+QPair<QList<QPair<QUrl, qint64> >, qint64> pandamonium_database::
+unvisitedChildUrls(const int depth, const qint64 rowid, const int limit)
+{
+  QPair<QList<QPair<QUrl, qint64> >, qint64> list;
+
+  /*
+  ** A range scan of the partial index pandamonium_visited_urls_unvisited,
+  ** whose entries, (depth, rowid), cover the unvisited rows only.
+  */
+
+  QSqlQuery query
+    (preparedQuery("pandamonium_visited_urls.db",
+		   "SELECT rowid, seed, url FROM pandamonium_visited_urls "
+		   "WHERE visited = 0 AND depth = ? AND rowid > ? "
+		   "ORDER BY rowid LIMIT ?"));
+
+  list.second = rowid;
+  query.bindValue(0, depth);
+  query.bindValue(1, rowid);
+  query.bindValue(2, qMax(1, limit));
+
+  if(query.exec())
+    while(query.next())
+      {
+	QUrl url(QUrl::fromEncoded(query.value(2).toByteArray()));
+
+	list.second = query.value(0).toLongLong();
+
+	if(!url.isEmpty())
+	  if(url.isValid())
+	    list.first << QPair<QUrl, qint64>
+	      (url, query.value(1).toLongLong());
+      }
+
+  query.finish();
+  return list;
+}
+
+QPair<QList<qint64>, qint64> pandamonium_database::visitedUrlHashes
+(const qint64 rowid, const int limit)
+{
+  QPair<QList<qint64>, qint64> list;
+  QSqlQuery query
+    (preparedQuery("pandamonium_visited_urls.db",
+		   "SELECT rowid, url_hash FROM pandamonium_visited_urls "
+		   "WHERE rowid > ? ORDER BY rowid LIMIT ?"));
+
+  list.second = rowid;
+  query.bindValue(0, rowid);
+  query.bindValue(1, qMax(1, limit));
+
+  if(query.exec())
+    while(query.next())
+      {
+	list.first << query.value(1).toLongLong();
+	list.second = query.value(0).toLongLong();
+      }
+
+  query.finish();
+  return list;
+}
+
+QPair<quint64, quint64> pandamonium_database::visitedUrlsCounts(void)
+{
+  /*
+  ** The numbers of unvisited and visited rows are maintained by the
+  ** triggers of pandamonium_visited_urls.
+  */
+
+  QSqlDatabase db(connection("pandamonium_visited_urls.db"));
+  QPair<quint64, quint64> numbers;
+
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.setForwardOnly(true);
+
+      if(query.exec("SELECT count, visited "
+		    "FROM pandamonium_visited_urls_counts"))
+	while(query.next())
+	  if(query.value(1).toInt() == 0)
 	    numbers.first = query.value(0).toULongLong();
-	    query.next();
+	  else
 	    numbers.second = query.value(0).toULongLong();
+    }
+
+  return numbers;
+}
+
+QPair<quint64, qint64> pandamonium_database::visitedUrlsExtent(void)
+{
+  QPair<quint64, qint64> extent;
+  QSqlDatabase db(connection("pandamonium_visited_urls.db"));
+
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.setForwardOnly(true);
+
+      if(query.exec("SELECT (SELECT SUM(count) FROM "
+		    "pandamonium_visited_urls_counts), "
+		    "(SELECT MAX(rowid) FROM pandamonium_visited_urls)"))
+	if(query.next())
+	  {
+	    extent.first = query.value(0).toULongLong();
+	    extent.second = query.value(1).toLongLong();
 	  }
-      }
+    }
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  return extent;
+}
 
-  QSqlDatabase::removeDatabase(pair.second);
-  return numbers;
+bool pandamonium_database::beginTransaction(const QString &fileName)
+{
+  QSqlDatabase db(connection(fileName));
+
+  if(!db.isOpen())
+    return false;
+
+  int &depth(connections()->m_transactions[absoluteFileName(fileName)]);
+
+  if(depth == 0)
+    if(!db.transaction())
+      return false;
+
+  depth += 1;
+  return true;
 }
 
-QUrl pandamonium_database::unvisitedChildUrl(void)
+bool pandamonium_database::endTransaction(const QString &fileName)
 {
-  QPair<QSqlDatabase, QString> pair;
-  QUrl new_url;
+  QString path(absoluteFileName(fileName));
+  pandamonium_database_connections *c = connections();
+
+  if(c->m_transactions.value(path) <= 0)
+    return false;
+
+  c->m_transactions[path] -= 1;
+
+  if(c->m_transactions.value(path) > 0)
+    return true;
+
+  QSqlDatabase db(connection(path));
+
+  if(db.commit())
+    return true;
+
+  db.rollback();
+  return false;
+}
+
+bool pandamonium_database::invalidateReplacedDatabases(void)
+{
+  /*
+  ** A database file which has been removed or replaced by another
+  ** process is invalidated.
+  */
+
+  QStringList list;
 
   {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_visited_urls.db");
+    QWriteLocker locker(&s_generationsLock);
+    QMutableHashIterator<QString, qint64> it(s_identities);
 
-    if(pair.first.open())
+    while(it.hasNext())
       {
-	QSqlQuery query(pair.first);
+	it.next();
 
-	query.setForwardOnly(true);
-	query.prepare
-	  ("SELECT url, visited FROM pandamonium_visited_urls "
-	   "WHERE visited = 0");
+	qint64 i = identity(it.key());
 
-	if(query.exec())
-	  if(query.next())
-	    new_url = QUrl::fromEncoded(query.value(0).toByteArray());
+	if(i != it.value())
+	  {
+	    list << it.key();
+	    it.remove();
+	  }
       }
-
-    pair.first.close();
-    pair.first = QSqlDatabase();
   }
 
-  QSqlDatabase::removeDatabase(pair.second);
-  return new_url;
+  foreach(const QString &fileName, list)
+    invalidate(fileName);
+
+  return !list.isEmpty();
+}
+
+bool pandamonium_database::isHashCollision(const QString &fileName,
+					  const QString &table,
+					  const qint64 hash,
+					  const QByteArray &url)
+{
+  /*
+  ** Is the hash of the URL the key of a different URL?
+  */
+
+  QByteArray bytes;
+  QSqlQuery query
+    (preparedQuery(fileName,
+		   QString("SELECT url FROM %1 WHERE url_hash = ?").arg(table)));
+
+  query.bindValue(0, hash);
+
+  if(query.exec() && query.next())
+    bytes = query.value(0).toByteArray();
+
+  query.finish();
+
+  if(bytes.isEmpty() || bytes == url)
+    return false;
+
+  qDebug() << "The URL " << url << " collides with " << bytes << " in "
+	   << table << "!";
+  return true;
 }
 
 bool pandamonium_database::isKernelActive(void)
 {
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_kernel_command.db"));
   bool active = false;
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_kernel_command.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.setForwardOnly(true);
+
+      if(query.exec("SELECT COUNT(*) FROM pandamonium_kernel_command"))
+	if(query.next())
+	  if(query.value(0).toLongLong() > 0)
+	    active = true;
+    }
+
+  return active;
+}
+
+bool pandamonium_database::isUrlParsed(const QUrl &url)
+{
+  QSqlQuery query
+    (preparedQuery("pandamonium_parsed_urls.db",
+		   "SELECT EXISTS(SELECT 1 FROM pandamonium_parsed_urls "
+		   "WHERE url_hash = ? AND url = ?)"));
+  QByteArray bytes(pandamonium_common::toEncoded(url));
+  bool state = false;
+
+  query.bindValue(0, urlHash(bytes));
+  query.bindValue(1, bytes);
+
+  if(query.exec() && query.next())
+    state = query.value(0).toBool();
+
+  query.finish();
+  return state;
+}
+
+bool pandamonium_database::saveExportDefinition
+(const QHash<QString, QString> &hash)
+{
+  QSqlDatabase db(connection("pandamonium_export_definition.db"));
+  bool ok = false;
+
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.prepare("INSERT OR REPLACE INTO pandamonium_export_definition("
+		    "database_path, database_table, "
+		    "field_content, "
+		    "field_description, field_title, field_url) "
+		    "VALUES(?, ?, ?, ?, ?, ?)");
+      query.bindValue(0, hash["database_path"]);
+      query.bindValue(1, hash["database_table"]);
+      query.bindValue(2, hash["field_content"]);
+      query.bindValue(3, hash["field_description"]);
+      query.bindValue(4, hash["field_title"]);
+      query.bindValue(5, hash["field_url"]);
+      ok = query.exec();
+    }
+
+  return ok;
+}
+
+bool pandamonium_database::shouldTerminateKernel(const qint64 process_id)
+{
+  QSqlDatabase db(connection("pandamonium_kernel_command.db"));
+  bool terminate = false;
+
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.setForwardOnly(true);
+      query.prepare("SELECT command FROM pandamonium_kernel_command "
+		    "WHERE kernel_process_id = ?");
+      query.bindValue(0, process_id);
+
+      if(query.exec())
+	{
+	  if(query.next())
+	    {
+	      if(query.value(0).toString().trimmed() == "terminate")
+		terminate = true;
+	    }
+	  else
+	    {
+	      query.exec("DELETE FROM pandamonium_kernel_command");
+	      terminate = true;
+	    }
+	}
+      else
+	terminate = true;
+    }
+  else
+    terminate = true;
+
+  return terminate;
+}
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+int pandamonium_database::minimumUnvisitedDepth(const int depth)
+{
+  QSqlDatabase db(connection("pandamonium_visited_urls.db"));
+  int minimum = -1;
 
-	query.setForwardOnly(true);
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-	if(query.exec("SELECT COUNT(*) FROM pandamonium_kernel_command"))
-	  if(query.next())
-	    if(query.value(0).toLongLong() > 0)
-	      active = true;
-      }
+      query.setForwardOnly(true);
+      query.prepare("SELECT MIN(depth) FROM pandamonium_visited_urls "
+		    "WHERE visited = 0 AND depth > ?");
+      query.bindValue(0, depth);
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      if(query.exec())
+	if(query.next())
+	  if(!query.isNull(0))
+	    minimum = query.value(0).toInt();
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
-  return active;
+  return minimum;
 }
 
-bool pandamonium_database::isUrlMetaDataOnly(const QUrl &url)
+qint64 pandamonium_database::changeInterval(const qint64 changes,
+					    const qint64 visits,
+					    const qint64 window)
 {
-  bool state = true;
-  QPair<QSqlDatabase, QString> pair;
+  static const qint64 maximum = qMax
+    (static_cast<qint64> (60),
+     QSettings().value("pandamonium_recrawl_maximum_interval", 2592000).
+     toLongLong());
+  static const qint64 minimum = qBound
+    (static_cast<qint64> (60),
+     QSettings().value("pandamonium_recrawl_minimum_interval", 3600).
+     toLongLong(),
+     maximum);
+
+  if(visits <= 1 || window <= 0)
+    return minimum;
+  else if(changes <= 0)
+    return qBound(minimum, 2 * window, maximum); // Back off.
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
+  /*
+  ** Changes are modeled as a Poisson process. Of n intervals of mean
+  ** length I, X revealed changes. The rate is estimated by
+  ** -ln((n - X + 0.5) / (n + 0.5)) / I, which remains finite if every
+  ** visit revealed a change.
+  */
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+  double n = static_cast<double> (visits - 1);
+  double x = static_cast<double> (qMin(changes, visits - 1));
+  double rate = -log((n - x + 0.5) / (n + 0.5)) / (window / n);
 
-	query.setForwardOnly(true);
-	query.prepare("SELECT meta_data_only "
-		      "FROM pandamonium_search_urls WHERE url = ?");
-	query.bindValue(0, pandamonium_common::toEncoded(url));
+  if(rate <= 0.0)
+    return maximum;
 
-	if(query.exec())
-	  if(query.next())
-	    state = query.value(0).toInt();
-      }
+  return qBound(minimum, static_cast<qint64> (1.0 / rate), maximum);
+}
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+qint64 pandamonium_database::identity(const QString &fileName)
+{
+  QFileInfo fileInfo(fileName);
 
-  QSqlDatabase::removeDatabase(pair.second);
-  return state;
+  if(!fileInfo.exists())
+    return -1;
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC) || defined(Q_OS_UNIX)
+  struct stat st;
+
+  if(stat(QFile::encodeName(fileName).constData(), &st) == 0)
+    return static_cast<qint64> (st.st_ino);
+#endif
+  return 0;
 }
 
-bool pandamonium_database::saveExportDefinition
-(const QHash<QString, QString> &hash)
+qint64 pandamonium_database::kernelProcessId(void)
 {
-  QPair<QSqlDatabase, QString> pair;
-  bool ok = false;
-
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_export_definition.db");
+  QSqlDatabase db(connection("pandamonium_kernel_command.db"));
+  qint64 process_id = 0;
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-	query.prepare("INSERT OR REPLACE INTO pandamonium_export_definition("
-		      "database_path, database_table, "
-		      "field_content, "
-		      "field_description, field_title, field_url) "
-		      "VALUES(?, ?, ?, ?, ?, ?)");
-	query.bindValue(0, hash["database_path"]);
-	query.bindValue(1, hash["database_table"]);
-	query.bindValue(2, hash["field_content"]);
-	query.bindValue(3, hash["field_description"]);
-	query.bindValue(4, hash["field_title"]);
-	query.bindValue(5, hash["field_url"]);
-	ok = query.exec();
-      }
+      query.setForwardOnly(true);
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      if(query.exec("SELECT kernel_process_id FROM "
+		    "pandamonium_kernel_command"))
+	if(query.next())
+	  process_id = query.value(0).toLongLong();
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
-  return ok;
+  return process_id;
 }
 
-bool pandamonium_database::shouldTerminateKernel(const qint64 process_id)
+qint64 pandamonium_database::parsedLinksCount(void)
 {
-  QPair<QSqlDatabase, QString> pair;
-  bool terminate = false;
+  QSqlDatabase db(connection("pandamonium_parsed_urls.db"));
+  qint64 count = 0;
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_kernel_command.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+      query.setForwardOnly(true);
 
-	query.setForwardOnly(true);
-	query.prepare("SELECT command FROM pandamonium_kernel_command "
-		      "WHERE kernel_process_id = ?");
-	query.bindValue(0, process_id);
+      if(query.exec("SELECT COUNT(*) FROM pandamonium_parsed_urls"))
+	if(query.next())
+	  count = query.value(0).toLongLong();
+    }
 
-	if(query.exec())
-	  {
-	    if(query.next())
-	      {
-		if(query.value(0).toString().trimmed() == "terminate")
-		  terminate = true;
-	      }
-	    else
-	      {
-		query.exec("DELETE FROM pandamonium_kernel_command");
-		terminate = true;
-	      }
-	  }
-	else
-	  terminate = true;
-      }
-    else
-      terminate = true;
+  return count;
+}
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+qint64 pandamonium_database::urlHash(const QByteArray &bytes)
+{
+  return static_cast<qint64> (pandamonium_common::hash(bytes));
+}
 
-  QSqlDatabase::removeDatabase(pair.second);
-  return terminate;
+quint64 pandamonium_database::generation(const QString &fileName)
+{
+  QReadLocker locker(&s_generationsLock);
+
+  return s_generations.value(fileName, 0);
 }
 
-qint64 pandamonium_database::kernelProcessId(void)
+quint64 pandamonium_database::markUrlsAsUnvisited
+(const QList<QUrl> &urls, const int depth, const qint64 seed)
 {
-  QPair<QSqlDatabase, QString> pair;
-  qint64 process_id = 0;
+  if(urls.isEmpty())
+    return 0;
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_kernel_command.db");
+  QFileInfo fileInfo
+    (pandamonium_common::homePath() + QDir::separator() +
+     "pandamonium_visited_urls.db");
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+  if(fileInfo.size() >= pandamonium_common::maximum_database_size)
+    return 0;
 
-	query.setForwardOnly(true);
+  /*
+  ** Remove duplicates before visiting the database.
+  */
 
-	if(query.exec("SELECT kernel_process_id FROM "
-		      "pandamonium_kernel_command"))
-	  if(query.next())
-	    process_id = query.value(0).toLongLong();
-      }
+  QList<QByteArray> list;
+  QSet<QByteArray> set;
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  for(int i = 0; i < urls.size(); i++)
+    {
+      QByteArray bytes(pandamonium_common::toEncoded(urls.at(i)));
 
-  QSqlDatabase::removeDatabase(pair.second);
-  return process_id;
-}
+      if(!bytes.isEmpty() && !set.contains(bytes))
+	{
+	  list << bytes;
+	  set.insert(bytes);
+	}
+    }
 
+  QString fileName(fileInfo.absoluteFilePath());
+  quint64 count = 0;
 
-qint64 pandamonium_database::parsedLinksCount(void)
-{
-  QPair<QSqlDatabase, QString> pair;
-  qint64 count = 0;
+  if(beginTransaction(fileName))
+    {
+      /*
+      ** Known URLs are only read. A hash which belongs to a different
+      ** URL is a collision.
+      */
+
+      QSqlQuery insert
+	(preparedQuery(fileName,
+		       "INSERT INTO pandamonium_visited_urls"
+		       "(depth, seed, url, url_hash, visited) "
+		       "VALUES(?, ?, ?, ?, 0)"));
+      QSqlQuery query
+	(preparedQuery(fileName,
+		       "SELECT url FROM pandamonium_visited_urls "
+		       "WHERE url_hash = ?"));
+
+      for(int i = 0; i < list.size(); i++)
+	{
+	  QByteArray bytes;
+	  qint64 hash = urlHash(list.at(i));
+
+	  query.bindValue(0, hash);
+
+	  if(!query.exec())
+	    continue;
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_parsed_urls.db");
+	  if(query.next())
+	    bytes = query.value(0).toByteArray();
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+	  query.finish();
 
-	query.setForwardOnly(true);
+	  if(!bytes.isEmpty())
+	    {
+	      if(bytes != list.at(i))
+		qDebug() << "The URL " << list.at(i) << " collides with "
+			 << bytes << " in pandamonium_visited_urls!";
 
-	if(query.exec("SELECT COUNT(*) FROM pandamonium_parsed_urls"))
-	  if(query.next())
-	    count = query.value(0).toLongLong();
-      }
+	      continue;
+	    }
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+	  insert.bindValue(0, qMax(0, depth));
+	  insert.bindValue(1, seed);
+	  insert.bindValue(2, list.at(i));
+	  insert.bindValue(3, hash);
+
+	  if(insert.exec() && insert.numRowsAffected() > 0)
+	    count += 1;
+	}
+
+      if(!endTransaction(fileName))
+	count = 0;
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
   return count;
 }
 
@@ -466,140 +1065,322 @@ void pandamonium_database::addSearchUrl(const QString &str)
   else if(!url.isValid())
     return;
 
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_search_urls.db"));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
+  if(db.isOpen())
+    {
+      QByteArray bytes(pandamonium_common::toEncoded(url));
+      QSqlQuery query(db);
+      qint64 hash = urlHash(bytes);
+
+      if(isHashCollision("pandamonium_search_urls.db",
+			 "pandamonium_search_urls",
+			 hash,
+			 bytes))
+	return;
+
+      query.prepare("INSERT OR REPLACE INTO pandamonium_search_urls"
+		    "(url, url_hash) "
+		    "VALUES(?, ?)");
+      query.bindValue(0, bytes);
+      query.bindValue(1, hash);
+      query.exec();
+    }
+}
 
-    if(pair.first.open())
-      {
-#if QT_VERSION >= 0x050100
-	QCryptographicHash hash(QCryptographicHash::Sha3_512);
-#elif QT_VERSION >= 0x050000
-	QCryptographicHash hash(QCryptographicHash::Sha512);
-#else
-	QCryptographicHash hash(QCryptographicHash::Sha1);
-#endif
-	QSqlQuery query(pair.first);
+void pandamonium_database::checkpoint(void)
+{
+  /*
+  ** A passive checkpoint never waits on readers or writers.
+  */
 
-	hash.addData(pandamonium_common::toEncoded(url));
-	query.prepare("INSERT OR REPLACE INTO pandamonium_search_urls"
-		      "(url, url_hash) "
-		      "VALUES(?, ?)");
-	query.bindValue(0, pandamonium_common::toEncoded(url));
-	query.bindValue(1, hash.result().toHex().constData());
-	query.exec();
-      }
+  foreach(const QString &fileName, fileNames())
+    {
+      QSqlDatabase db(connection(fileName));
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      if(db.isOpen())
+	{
+	  QSqlQuery query(db);
 
-  QSqlDatabase::removeDatabase(pair.second);
+	  query.exec("PRAGMA wal_checkpoint(PASSIVE)");
+	}
+    }
 }
 
 void pandamonium_database::createdb(void)
 {
-  QStringList fileNames;
-
-  fileNames << "pandamonium_broken_urls.db"
-	    << "pandamonium_export_definition.db"
-	    << "pandamonium_kernel_command.db"
-	    << "pandamonium_parsed_urls.db"
-	    << "pandamonium_search_urls.db"
-	    << "pandamonium_visited_urls.db";
-
-  foreach(const QString &fileName, fileNames)
+  foreach(const QString &fileName, fileNames())
     {
-      QPair<QSqlDatabase, QString> pair;
+      QSqlDatabase db(connection(fileName));
 
-      {
-	pair = database();
-	pair.first.setDatabaseName
-	  (pandamonium_common::homePath() + QDir::separator() + fileName);
+      if(db.isOpen())
+	{
+	  QSqlQuery query(db);
 
-	if(pair.first.open())
-	  {
-	    QSqlQuery query(pair.first);
+	  /*
+	  ** The journal mode is persistent. Readers and the writer
+	  ** do not block one another.
+	  */
 
-	    if(fileName == "pandamonium_broken_urls.db")
-	      query.exec
+	  query.exec("PRAGMA journal_mode = WAL");
+
+	  if(fileName == "pandamonium_broken_urls.db")
+	    {
+	      QString statement
 		("CREATE TABLE IF NOT EXISTS pandamonium_broken_urls("
 		 "error_string TEXT NOT NULL, "
 		 "url TEXT NOT NULL, "
-		 "url_hash TEXT NOT NULL PRIMARY KEY, "
+		 "url_hash INTEGER NOT NULL PRIMARY KEY, "
 		 "url_parent TEXT NOT NULL)");
-	    else if(fileName == "pandamonium_export_definition.db")
-	      {
-		query.exec
-		  ("CREATE TABLE IF NOT EXISTS pandamonium_export_definition("
-		   "database_path TEXT NOT NULL, "
-		   "database_table TEXT NOT NULL, "
-		   "field_content BLOB NOT NULL, "
-		   "field_description TEXT NOT NULL, "
-		   "field_title TEXT NOT NULL, "
-		   "field_url TEXT NOT NULL, "
-		   "PRIMARY KEY(database_path, "
-		   "database_table, field_description, field_title, "
-		   "field_url))");
-		query.exec
-		  ("CREATE TRIGGER IF NOT EXISTS "
-		   "pandamonium_export_definition_trigger "
-		   "BEFORE INSERT ON pandamonium_export_definition "
-		   "BEGIN "
-		   "DELETE FROM pandamonium_export_definition;"
-		   "END");
-	      }
-	    else if(fileName == "pandamonium_kernel_command.db")
-	      {
-		query.exec
-		  ("CREATE TABLE IF NOT EXISTS pandamonium_kernel_command("
-		   "command TEXT NOT NULL CHECK "
-		   "(command IN ('rove', 'terminate')), "
-		   "kernel_process_id INTEGER NOT NULL PRIMARY KEY)");
-		query.exec
-		  ("CREATE TRIGGER IF NOT EXISTS "
-		   "pandamonium_kernel_command_trigger "
-		   "BEFORE INSERT ON pandamonium_kernel_command "
-		   "BEGIN "
-		   "DELETE FROM pandamonium_kernel_command;"
-		   "END");
-	      }
-	    else if(fileName == "pandamonium_parsed_urls.db")
+
+	      query.exec(statement);
+	      migrateUrlKeys
+		(fileName, "pandamonium_broken_urls", statement, false);
+	    }
+	  else if(fileName == "pandamonium_export_definition.db")
+	    {
+	      query.exec
+		("CREATE TABLE IF NOT EXISTS pandamonium_export_definition("
+		 "database_path TEXT NOT NULL, "
+		 "database_table TEXT NOT NULL, "
+		 "field_content BLOB NOT NULL, "
+		 "field_description TEXT NOT NULL, "
+		 "field_title TEXT NOT NULL, "
+		 "field_url TEXT NOT NULL, "
+		 "PRIMARY KEY(database_path, "
+		 "database_table, field_description, field_title, "
+		 "field_url))");
+	      query.exec
+		("CREATE TRIGGER IF NOT EXISTS "
+		 "pandamonium_export_definition_trigger "
+		 "BEFORE INSERT ON pandamonium_export_definition "
+		 "BEGIN "
+		 "DELETE FROM pandamonium_export_definition;"
+		 "END");
+	    }
+	  else if(fileName == "pandamonium_kernel_command.db")
+	    {
+	      query.exec
+		("CREATE TABLE IF NOT EXISTS pandamonium_kernel_command("
+		 "command TEXT NOT NULL CHECK "
+		 "(command IN ('rove', 'terminate')), "
+		 "kernel_process_id INTEGER NOT NULL PRIMARY KEY)");
 	      query.exec
+		("CREATE TRIGGER IF NOT EXISTS "
+		 "pandamonium_kernel_command_trigger "
+		 "BEFORE INSERT ON pandamonium_kernel_command "
+		 "BEGIN "
+		 "DELETE FROM pandamonium_kernel_command;"
+		 "END");
+	    }
+	  else if(fileName == "pandamonium_parsed_urls.db")
+	    {
+	      QString statement
 		("CREATE TABLE IF NOT EXISTS pandamonium_parsed_urls("
+		 "change_interval INTEGER NOT NULL DEFAULT 0, "
+		 "changes INTEGER NOT NULL DEFAULT 0, "
 		 "content BLOB TEXT NOT NULL, "
+		 "content_hash TEXT, "
 		 "description TEXT NOT NULL, " // Not a BLOB?
+		 "etag TEXT, "
+		 "last_modified TEXT, "
+		 "time_changed INTEGER NOT NULL DEFAULT 0, "
+		 "time_due INTEGER NOT NULL DEFAULT 0, "
+		 "time_first INTEGER NOT NULL DEFAULT 0, "
 		 "time_inserted INTEGER NOT NULL, "
+		 "time_validated INTEGER NOT NULL DEFAULT 0, "
 		 "title TEXT NOT NULL, "
-		 "url TEXT NOT NULL PRIMARY KEY)");
-	    else if(fileName == "pandamonium_search_urls.db")
+		 "url TEXT NOT NULL, "
+		 "url_hash INTEGER NOT NULL PRIMARY KEY, "
+		 "visits INTEGER NOT NULL DEFAULT 1)");
+
+	      query.exec(statement);
+
+	      /*
+	      ** Older databases.
+	      */
+
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD "
+			 "change_interval INTEGER NOT NULL DEFAULT 0");
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD "
+			 "changes INTEGER NOT NULL DEFAULT 0");
 	      query.exec
+		("ALTER TABLE pandamonium_parsed_urls ADD content_hash TEXT");
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD etag TEXT");
+	      query.exec
+		("ALTER TABLE pandamonium_parsed_urls ADD last_modified TEXT");
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD "
+			 "time_changed INTEGER NOT NULL DEFAULT 0");
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD "
+			 "time_due INTEGER NOT NULL DEFAULT 0");
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD "
+			 "time_first INTEGER NOT NULL DEFAULT 0");
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD "
+			 "time_validated INTEGER NOT NULL DEFAULT 0");
+	      query.exec("ALTER TABLE pandamonium_parsed_urls ADD "
+			 "visits INTEGER NOT NULL DEFAULT 1");
+	      migrateUrlKeys
+		(fileName, "pandamonium_parsed_urls", statement, false);
+	      query.exec
+		("CREATE INDEX IF NOT EXISTS pandamonium_parsed_urls_time_due "
+		 "ON pandamonium_parsed_urls(time_due)");
+	    }
+	  else if(fileName == "pandamonium_search_urls.db")
+	    {
+	      QString statement
 		("CREATE TABLE IF NOT EXISTS pandamonium_search_urls("
+		 "concurrency INTEGER NOT NULL DEFAULT 1, "
+		 "head_only INTEGER NOT NULL DEFAULT 0, "
 		 "meta_data_only INTEGER NOT NULL DEFAULT 1, "
 		 "paused INTEGER NOT NULL DEFAULT 0, "
 		 "request_interval REAL NOT NULL DEFAULT 0.50, "
 		 "search_depth INTEGER NOT NULL DEFAULT -1, "
 		 "url TEXT NOT NULL, "
-		 "url_hash TEXT NOT NULL PRIMARY KEY)");
-	    else if(fileName == "pandamonium_visited_urls.db")
+		 "url_hash INTEGER NOT NULL PRIMARY KEY)");
+
+	      query.exec(statement);
+
+	      /*
+	      ** Older databases.
+	      */
+
+	      query.exec("ALTER TABLE pandamonium_search_urls ADD "
+			 "concurrency INTEGER NOT NULL DEFAULT 1");
+	      query.exec("ALTER TABLE pandamonium_search_urls ADD "
+			 "head_only INTEGER NOT NULL DEFAULT 0");
+	      migrateUrlKeys
+		(fileName, "pandamonium_search_urls", statement, false);
+	    }
+	  else if(fileName == "pandamonium_statistics.db")
+	    {
+	      query.exec
+		("CREATE TABLE IF NOT EXISTS pandamonium_depth_statistics("
+		 "depth INTEGER NOT NULL PRIMARY KEY, "
+		 "discovered INTEGER NOT NULL DEFAULT 0, "
+		 "fetched INTEGER NOT NULL DEFAULT 0)");
 	      query.exec
+		("CREATE TABLE IF NOT EXISTS pandamonium_counters("
+		 "name TEXT NOT NULL PRIMARY KEY, "
+		 "value INTEGER NOT NULL DEFAULT 0)");
+	      query.exec
+		("CREATE TABLE IF NOT EXISTS pandamonium_host_statistics("
+		 "decoded_bytes INTEGER NOT NULL DEFAULT 0, "
+		 "host TEXT NOT NULL PRIMARY KEY, "
+		 "wire_bytes INTEGER NOT NULL DEFAULT 0)");
+	    }
+	  else if(fileName == "pandamonium_visited_urls.db")
+	    {
+	      /*
+	      ** The rowids order the frontier. They are never reused so
+	      ** that rows which are inserted after a depth's cursor are
+	      ** not placed behind it. The hashes are unique. The seed
+	      ** identifies the search URL which discovered a URL. Zero
+	      ** is unknown.
+	      */
+
+	      QString statement
 		("CREATE TABLE IF NOT EXISTS pandamonium_visited_urls("
-		 "url TEXT NOT NULL PRIMARY KEY, "
+		 "depth INTEGER NOT NULL DEFAULT 0, "
+		 "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+		 "seed INTEGER NOT NULL DEFAULT 0, "
+		 "url TEXT NOT NULL, "
+		 "url_hash INTEGER NOT NULL UNIQUE, "
 		 "visited INTEGER NOT NULL DEFAULT 0)");
-	  }
 
-	pair.first.close();
-	pair.first = QSqlDatabase();
-      }
+	      query.exec(statement);
 
-      QSqlDatabase::removeDatabase(pair.second);
+	      /*
+	      ** Older databases.
+	      */
+
+	      query.exec("ALTER TABLE pandamonium_visited_urls ADD "
+			 "depth INTEGER NOT NULL DEFAULT 0");
+	      query.exec("ALTER TABLE pandamonium_visited_urls ADD "
+			 "seed INTEGER NOT NULL DEFAULT 0");
+	      migrateUrlKeys
+		(fileName, "pandamonium_visited_urls", statement, true);
+
+	      /*
+	      ** The frontier reads unvisited rows by depth and rowid.
+	      ** Visited rows are not indexed.
+	      */
+
+	      query.exec("DROP INDEX IF EXISTS pandamonium_visited_urls_index");
+	      query.exec
+		("CREATE INDEX IF NOT EXISTS "
+		 "pandamonium_visited_urls_unvisited "
+		 "ON pandamonium_visited_urls(depth) WHERE visited = 0");
+	      query.exec
+		("CREATE TABLE IF NOT EXISTS pandamonium_visited_urls_counts("
+		 "count INTEGER NOT NULL DEFAULT 0, "
+		 "visited INTEGER NOT NULL PRIMARY KEY)");
+	      query.exec
+		("CREATE TRIGGER IF NOT EXISTS "
+		 "pandamonium_visited_urls_delete_trigger "
+		 "AFTER DELETE ON pandamonium_visited_urls "
+		 "BEGIN "
+		 "UPDATE pandamonium_visited_urls_counts "
+		 "SET count = count - 1 WHERE visited = OLD.visited; "
+		 "END");
+	      query.exec
+		("CREATE TRIGGER IF NOT EXISTS "
+		 "pandamonium_visited_urls_insert_trigger "
+		 "AFTER INSERT ON pandamonium_visited_urls "
+		 "BEGIN "
+		 "UPDATE pandamonium_visited_urls_counts "
+		 "SET count = count + 1 WHERE visited = NEW.visited; "
+		 "END");
+	      query.exec
+		("CREATE TRIGGER IF NOT EXISTS "
+		 "pandamonium_visited_urls_update_trigger "
+		 "AFTER UPDATE OF visited ON pandamonium_visited_urls "
+		 "WHEN OLD.visited <> NEW.visited "
+		 "BEGIN "
+		 "UPDATE pandamonium_visited_urls_counts "
+		 "SET count = count - 1 WHERE visited = OLD.visited; "
+		 "UPDATE pandamonium_visited_urls_counts "
+		 "SET count = count + 1 WHERE visited = NEW.visited; "
+		 "END");
+
+	      /*
+	      ** The counts of new and older databases are computed once.
+	      */
+
+	      if(query.exec("SELECT COUNT(*) "
+			    "FROM pandamonium_visited_urls_counts") &&
+		 query.next() &&
+		 query.value(0).toLongLong() == 0)
+		{
+		  query.finish();
+
+		  if(db.transaction())
+		    {
+		      if(query.exec
+			 ("INSERT INTO pandamonium_visited_urls_counts"
+			  "(count, visited) "
+			  "SELECT COUNT(*), 0 FROM pandamonium_visited_urls "
+			  "WHERE visited = 0 UNION ALL "
+			  "SELECT COUNT(*), 1 FROM pandamonium_visited_urls "
+			  "WHERE visited = 1"))
+			db.commit();
+		      else
+			db.rollback();
+		    }
+		}
+	    }
+	}
     }
 }
 
+void pandamonium_database::disableAutomaticCheckpoints(void)
+{
+  /*
+  ** The caller assumes responsibility for checkpoint().
+  */
+
+  s_automaticCheckpoints.fetchAndStoreOrdered(0);
+}
+
 void pandamonium_database::exportUrl
 (const QString &str, const bool shouldDelete)
 {
@@ -616,44 +1397,35 @@ void pandamonium_database::exportUrl
   ** Now, let's retrieve the URL's data.
   */
 
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_parsed_urls.db"));
   QList<QVariant> values;
   bool ok = false;
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_parsed_urls.db");
-
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-
-	query.setForwardOnly(true);
-	query.prepare("SELECT content, description, title FROM "
-		      "pandamonium_parsed_urls WHERE url = ?");
-	query.bindValue(0, pandamonium_common::toEncoded(QUrl(str)));
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-	if(query.exec())
-	  if(query.next())
-	    {
-	      ok = true;
-	      values << query.value(0).toByteArray()
-		     << query.value(1).toString().trimmed()
-		     << query.value(2).toString().trimmed()
-		     << str;
-	    }
+      query.setForwardOnly(true);
+      QByteArray bytes(pandamonium_common::toEncoded(QUrl(str)));
 
-	if(!ok)
-	  qDebug() << str << QUrl(str) << query.lastError();
-      }
+      query.prepare("SELECT content, description, title FROM "
+		    "pandamonium_parsed_urls WHERE url_hash = ? AND url = ?");
+      query.bindValue(0, urlHash(bytes));
+      query.bindValue(1, bytes);
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      if(query.exec())
+	if(query.next())
+	  {
+	    ok = true;
+	    values << query.value(0).toByteArray()
+		   << query.value(1).toString().trimmed()
+		   << query.value(2).toString().trimmed()
+		   << str;
+	  }
 
-  QSqlDatabase::removeDatabase(pair.second);
+      if(!ok)
+	qDebug() << str << QUrl(str) << query.lastError();
+    }
 
   if(!ok)
     return;
@@ -664,6 +1436,8 @@ void pandamonium_database::exportUrl
   ** Now, let's write the URL to the export database.
   */
 
+  QPair<QSqlDatabase, QString> pair;
+
   {
     pair = database();
     pair.first.setDatabaseName(hash.value("database_path"));
@@ -694,19 +1468,128 @@ void pandamonium_database::exportUrl
     pair.first = QSqlDatabase();
   }
 
-  QSqlDatabase::removeDatabase(pair.second);
+  QSqlDatabase::removeDatabase(pair.second);
+
+  /*
+  ** Finally, remove the URL.
+  */
+
+  if(ok)
+    if(shouldDelete)
+      removeParsedUrls(QStringList() << str);
+}
+
+void pandamonium_database::invalidate(const QString &fileName)
+{
+  QString path(absoluteFileName(fileName));
+
+  {
+    QWriteLocker locker(&s_generationsLock);
+
+    s_generations[path] += 1;
+    s_identities.remove(path);
+  }
+
+  /*
+  ** Other threads will discard their connections during their
+  ** next request.
+  */
+
+  connections()->close(path);
+}
+
+void pandamonium_database::markUrlAsValidated(const QUrl &url)
+{
+  /*
+  ** The content of the URL has not changed. The next revisit is
+  ** postponed.
+  */
+
+  QByteArray bytes(pandamonium_common::toEncoded(url));
+  QSqlQuery query
+    (preparedQuery("pandamonium_parsed_urls.db",
+		   "SELECT changes, time_first, visits "
+		   "FROM pandamonium_parsed_urls "
+		   "WHERE url_hash = ? AND url = ?"));
+  qint64 hash = urlHash(bytes);
+  qint64 now = static_cast<qint64> (QDateTime::currentDateTime().toTime_t());
+
+  query.bindValue(0, hash);
+  query.bindValue(1, bytes);
+
+  if(!query.exec() || !query.next())
+    {
+      query.finish();
+      return;
+    }
+
+  qint64 changes = query.value(0).toLongLong();
+  qint64 first = query.value(1).toLongLong();
+  qint64 visits = query.value(2).toLongLong() + 1;
+
+  query.finish();
+
+  if(first <= 0)
+    first = now; // An older row.
+
+  qint64 interval = changeInterval(changes, visits, now - first);
+  QSqlQuery update
+    (preparedQuery("pandamonium_parsed_urls.db",
+		   "UPDATE pandamonium_parsed_urls "
+		   "SET change_interval = ?, time_due = ?, time_first = ?, "
+		   "time_validated = ?, visits = ? "
+		   "WHERE url_hash = ? AND url = ?"));
+
+  update.bindValue(0, interval);
+  update.bindValue(1, now + interval);
+  update.bindValue(2, first);
+  update.bindValue(3, now);
+  update.bindValue(4, visits);
+  update.bindValue(5, hash);
+  update.bindValue(6, bytes);
+  update.exec();
+}
 
+void pandamonium_database::markUrlsAsModified
+(const QList<QPair<QUrl, qint64> > &list)
+{
   /*
-  ** Finally, remove the URL.
+  ** Parsed URLs which were modified after they were last fetched are
+  ** due at their modification times.
   */
 
-  if(ok)
-    if(shouldDelete)
-      removeParsedUrls(QStringList() << str);
+  if(list.isEmpty())
+    return;
+
+  if(beginTransaction("pandamonium_parsed_urls.db"))
+    {
+      QSqlQuery query
+	(preparedQuery("pandamonium_parsed_urls.db",
+		       "UPDATE pandamonium_parsed_urls SET time_due = ? "
+		       "WHERE url_hash = ? AND url = ? AND time_due > ? AND "
+		       "time_validated < ?"));
+      qint64 now = static_cast<qint64>
+	(QDateTime::currentDateTime().toTime_t());
+
+      for(int i = 0; i < list.size(); i++)
+	{
+	  QByteArray bytes(pandamonium_common::toEncoded(list.at(i).first));
+	  qint64 time = qMin(now, list.at(i).second);
+
+	  query.bindValue(0, time);
+	  query.bindValue(1, urlHash(bytes));
+	  query.bindValue(2, bytes);
+	  query.bindValue(3, time);
+	  query.bindValue(4, time);
+	  query.exec();
+	}
+
+      endTransaction("pandamonium_parsed_urls.db");
+    }
 }
 
 void pandamonium_database::markUrlAsVisited
-(const QUrl &url, const bool visited)
+(const QUrl &url, const bool visited, const int depth)
 {
   QFileInfo fileInfo
     (pandamonium_common::homePath() + QDir::separator() +
@@ -715,38 +1598,147 @@ void pandamonium_database::markUrlAsVisited
   if(fileInfo.size() >= pandamonium_common::maximum_database_size)
     return;
 
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection(fileInfo.absoluteFilePath()));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName(fileInfo.absoluteFilePath());
+  if(db.isOpen())
+    {
+      QByteArray bytes(pandamonium_common::toEncoded(url));
+      QSqlQuery query(db);
+      qint64 hash = urlHash(bytes);
+
+      if(isHashCollision(fileInfo.absoluteFilePath(),
+			 "pandamonium_visited_urls",
+			 hash,
+			 bytes))
+	return;
+
+      /*
+      ** A known row is updated in place so that it retains its rowid.
+      */
+
+      if(visited)
+	{
+	  query.prepare("UPDATE pandamonium_visited_urls "
+			"SET depth = ?, visited = 1 "
+			"WHERE url_hash = ? AND url = ?");
+	  query.bindValue(0, qMax(0, depth));
+	  query.bindValue(1, hash);
+	  query.bindValue(2, bytes);
+
+	  if(query.exec() && query.numRowsAffected() > 0)
+	    return;
+	}
+
+      query.prepare("INSERT INTO pandamonium_visited_urls"
+		    "(depth, url, url_hash, visited) "
+		    "VALUES(?, ?, ?, ?)");
+      query.bindValue(0, qMax(0, depth));
+      query.bindValue(1, bytes);
+      query.bindValue(2, hash);
+      query.bindValue(3, visited ? 1 : 0);
+      query.exec();
+    }
+}
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+void pandamonium_database::migrateUrlKeys(const QString &fileName,
+					  const QString &table,
+					  const QString &statement,
+					  const bool rowids)
+{
+  /*
+  ** Tables of older databases are keyed on URLs or on hexadecimal
+  ** SHA digests. Their rows are copied into tables which are keyed on
+  ** 64-bit URL hashes. If rowids is true, the rowids are preserved in
+  ** the table's AUTOINCREMENT id column, which older tables lack.
+  */
 
-	if(visited)
-	  query.prepare("INSERT OR REPLACE INTO pandamonium_visited_urls"
-			"(url, visited) "
-			"VALUES(?, ?)");
-	else
-	  {
-	    query.exec("PRAGMA synchronous = OFF");
-	    query.prepare("INSERT INTO pandamonium_visited_urls"
-			  "(url, visited) "
-			  "VALUES(?, ?)");
-	  }
+  QSqlDatabase db(connection(fileName));
 
-	query.bindValue(0, pandamonium_common::toEncoded(url));
-	query.bindValue(1, visited ? 1 : 0);
-	query.exec();
-      }
+  if(!db.isOpen())
+    return;
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  QSqlQuery query(db);
+  QStringList columns;
+  bool current = false;
+  bool id = false;
 
-  QSqlDatabase::removeDatabase(pair.second);
+  query.setForwardOnly(true);
+
+  if(query.exec(QString("PRAGMA table_info(%1)").arg(table)))
+    while(query.next())
+      if(query.value(1).toString() == "id")
+	id = true;
+      else if(query.value(1).toString() == "url_hash")
+	current = query.value(2).toString().toUpper() == "INTEGER";
+      else
+	columns << query.value(1).toString();
+
+  if(rowids && !id)
+    current = false;
+
+  if(current || !columns.contains("url"))
+    return;
+
+  if(!db.transaction())
+    return;
+
+  QString names(columns.join(", "));
+  bool ok = query.exec(QString("ALTER TABLE %1 RENAME TO %1_migration").
+		       arg(table)) && query.exec(statement);
+  int index = columns.indexOf("url");
+  quint64 collisions = 0;
+
+  if(ok)
+    {
+      QSqlQuery insert(db);
+
+      if(rowids)
+	insert.prepare
+	  (QString("INSERT OR IGNORE INTO %1(rowid, %2, url_hash) "
+		   "VALUES(?, %3?)").
+	   arg(table).arg(names).arg(QString("?, ").repeated(columns.size())));
+      else
+	insert.prepare
+	  (QString("INSERT OR IGNORE INTO %1(%2, url_hash) VALUES(%3?)").
+	   arg(table).arg(names).arg(QString("?, ").repeated(columns.size())));
+
+      ok = query.exec(QString("SELECT rowid, %1 FROM %2_migration "
+			      "ORDER BY rowid").arg(names).arg(table));
+
+      while(ok && query.next())
+	{
+	  int offset = rowids ? 1 : 0;
+
+	  if(rowids)
+	    insert.bindValue(0, query.value(0));
+
+	  for(int i = 0; i < columns.size(); i++)
+	    insert.bindValue(i + offset, query.value(i + 1));
+
+	  insert.bindValue
+	    (columns.size() + offset,
+	     urlHash(query.value(index + 1).toByteArray()));
+	  ok = insert.exec();
+
+	  if(ok && insert.numRowsAffected() <= 0)
+	    collisions += 1;
+	}
+    }
+
+  if(ok)
+    ok = query.exec(QString("DROP TABLE %1_migration").arg(table));
+
+  if(ok && db.commit())
+    {
+      if(collisions > 0)
+	qDebug() << collisions << " colliding URLs were discarded from "
+		 << table << "!";
+    }
+  else
+    {
+      qDebug() << "Cannot migrate " << table << ": " << query.lastError();
+      db.rollback();
+    }
 }
 
 void pandamonium_database::recordBrokenUrl(const QString &error_string,
@@ -757,113 +1749,106 @@ void pandamonium_database::recordBrokenUrl(const QString &error_string,
      parent_url.isEmpty() || !parent_url.isValid())
     return;
 
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_broken_urls.db");
-
-    if(pair.first.open())
-      {
-#if QT_VERSION >= 0x050100
-	QCryptographicHash hash(QCryptographicHash::Sha3_512);
-#elif QT_VERSION >= 0x050000
-	QCryptographicHash hash(QCryptographicHash::Sha512);
-#else
-	QCryptographicHash hash(QCryptographicHash::Sha1);
-#endif
-	QSqlQuery query(pair.first);
-
-	hash.addData(pandamonium_common::toEncoded(child_url));
-	query.prepare("INSERT OR REPLACE INTO pandamonium_broken_urls"
-		      "(error_string, url, url_hash, url_parent) "
-		      "VALUES(?, ?, ?, ?)");
-	query.bindValue(0, error_string.trimmed());
-	query.bindValue(1, pandamonium_common::toEncoded(child_url));
-	query.bindValue(2, hash.result().toHex().constData());
-	query.bindValue(3, pandamonium_common::toEncoded(parent_url));
-	query.exec();
-      }
-
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  QSqlDatabase db(connection("pandamonium_broken_urls.db"));
 
-  QSqlDatabase::removeDatabase(pair.second);
+  if(db.isOpen())
+    {
+      QByteArray bytes(pandamonium_common::toEncoded(child_url));
+      QSqlQuery query(db);
+      qint64 hash = urlHash(bytes);
+
+      if(isHashCollision("pandamonium_broken_urls.db",
+			 "pandamonium_broken_urls",
+			 hash,
+			 bytes))
+	return;
+
+      query.prepare("INSERT OR REPLACE INTO pandamonium_broken_urls"
+		    "(error_string, url, url_hash, url_parent) "
+		    "VALUES(?, ?, ?, ?)");
+      query.bindValue(0, error_string.trimmed());
+      query.bindValue(1, bytes);
+      query.bindValue(2, hash);
+      query.bindValue(3, pandamonium_common::toEncoded(parent_url));
+      query.exec();
+    }
 }
 
 void pandamonium_database::recordKernelDeactivation(const qint64 process_id)
 {
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_kernel_command.db"));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_kernel_command.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      if(process_id == 0)
+	query.exec("DELETE FROM pandamonium_kernel_command");
+      else
+	{
+	  query.prepare("DELETE FROM pandamonium_kernel_command "
+			"WHERE kernel_process_id = ?");
+	  query.bindValue(0, process_id);
+	  query.exec();
+	}
+    }
+}
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+void pandamonium_database::recordKernelProcessId(const qint64 process_id)
+{
+  QSqlDatabase db(connection("pandamonium_kernel_command.db"));
 
-	if(process_id == 0)
-	  query.exec("DELETE FROM pandamonium_kernel_command");
-	else
-	  {
-	    query.prepare("DELETE FROM pandamonium_kernel_command "
-			  "WHERE kernel_process_id = ?");
-	    query.bindValue(0, process_id);
-	    query.exec();
-	  }
-      }
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+      bool ok = true;
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      query.setForwardOnly(true);
 
-  QSqlDatabase::removeDatabase(pair.second);
+      if(query.exec("SELECT command FROM pandamonium_kernel_command"))
+	if(query.next())
+	  if(query.value(0).toString().trimmed() == "terminate")
+	    ok = false;
+
+      if(ok)
+	{
+	  query.prepare("INSERT INTO pandamonium_kernel_command"
+			"(command, kernel_process_id) "
+			"VALUES(?, ?)");
+	  query.bindValue(0, "rove");
+	  query.bindValue(1, process_id);
+	  query.exec();
+	}
+    }
 }
 
-void pandamonium_database::recordKernelProcessId(const qint64 process_id)
+void pandamonium_database::remove(const QString &fileName)
 {
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_kernel_command.db");
-
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-	bool ok = true;
+  QString path(absoluteFileName(fileName));
 
-	query.setForwardOnly(true);
+  invalidate(path);
+  QFile::remove(path);
+  QFile::remove(path + "-shm");
+  QFile::remove(path + "-wal");
 
-	if(query.exec("SELECT command FROM pandamonium_kernel_command"))
-	  if(query.next())
-	    if(query.value(0).toString().trimmed() == "terminate")
-	      ok = false;
+  if(fileName.endsWith("pandamonium_visited_urls.db"))
+    {
+      QDir dir(pandamonium_common::homePath());
+      QHash<QString, quint64> gauges;
 
-	if(ok)
-	  {
-	    query.prepare("INSERT INTO pandamonium_kernel_command"
-			  "(command, kernel_process_id) "
-			  "VALUES(?, ?)");
-	    query.bindValue(0, "rove");
-	    query.bindValue(1, process_id);
-	    query.exec();
-	  }
-      }
+      /*
+      ** The URL store's segments.
+      */
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      foreach(const QString &name,
+	      dir.entryList(QStringList() << "pandamonium_visited_urls.store*",
+			    QDir::Files))
+	QFile::remove(dir.absoluteFilePath(name));
 
-  QSqlDatabase::removeDatabase(pair.second);
+      gauges["url_store_bytes"] = 0;
+      gauges["url_store_urls"] = 0;
+      saveGauges(gauges);
+    }
 }
 
 void pandamonium_database::removeBrokenUrls(const QStringList &list)
@@ -871,34 +1856,22 @@ void pandamonium_database::removeBrokenUrls(const QStringList &list)
   if(list.isEmpty())
     return;
 
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_broken_urls.db");
-
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-
-	query.exec("PRAGMA secure_delete = ON");
+  QSqlDatabase db(connection("pandamonium_broken_urls.db"));
 
-	foreach(const QString &str, list)
-	  {
-	    query.prepare("DELETE FROM pandamonium_broken_urls "
-			  "WHERE url_hash = ?");
-	    query.bindValue(0, str);
-	    query.exec();
-	  }
-      }
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      query.exec("PRAGMA secure_delete = ON");
 
-  QSqlDatabase::removeDatabase(pair.second);
+      foreach(const QString &str, list)
+	{
+	  query.prepare("DELETE FROM pandamonium_broken_urls "
+			"WHERE url_hash = ?");
+	  query.bindValue(0, str.toLongLong());
+	  query.exec();
+	}
+    }
 }
 
 void pandamonium_database::removeParsedUrls(const QStringList &list)
@@ -906,34 +1879,25 @@ void pandamonium_database::removeParsedUrls(const QStringList &list)
   if(list.isEmpty())
     return;
 
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_parsed_urls.db");
-
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+  QSqlDatabase db(connection("pandamonium_parsed_urls.db"));
 
-	query.exec("PRAGMA secure_delete = ON");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-	foreach(QString str, list)
-	  {
-	    query.prepare("DELETE FROM pandamonium_parsed_urls "
-			  "WHERE url = ?");
-	    query.bindValue(0, pandamonium_common::toEncoded(QUrl(str)));
-	    query.exec();
-	  }
-      }
+      query.exec("PRAGMA secure_delete = ON");
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      foreach(QString str, list)
+	{
+	  QByteArray bytes(pandamonium_common::toEncoded(QUrl(str)));
 
-  QSqlDatabase::removeDatabase(pair.second);
+	  query.prepare("DELETE FROM pandamonium_parsed_urls "
+			"WHERE url_hash = ? AND url = ?");
+	  query.bindValue(0, urlHash(bytes));
+	  query.bindValue(1, bytes);
+	  query.exec();
+	}
+    }
 }
 
 void pandamonium_database::removeSearchUrls(const QStringList &list)
@@ -941,97 +1905,230 @@ void pandamonium_database::removeSearchUrls(const QStringList &list)
   if(list.isEmpty())
     return;
 
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_search_urls.db"));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+      query.exec("PRAGMA secure_delete = ON");
 
-	query.exec("PRAGMA secure_delete = ON");
+      foreach(QString str, list)
+	{
+	  query.prepare("DELETE FROM pandamonium_search_urls "
+			"WHERE url_hash = ?");
+	  query.bindValue(0, str.toLongLong());
+	  query.exec();
+	}
+    }
+}
 
-	foreach(QString str, list)
-	  {
-	    query.prepare("DELETE FROM pandamonium_search_urls "
-			  "WHERE url_hash = ?");
-	    query.bindValue(0, str);
-	    query.exec();
-	  }
-      }
+void pandamonium_database::removeVisitedUrls(const QList<qint64> &rowids)
+{
+  if(rowids.isEmpty())
+    return;
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  if(beginTransaction("pandamonium_visited_urls.db"))
+    {
+      QSqlQuery query
+	(preparedQuery("pandamonium_visited_urls.db",
+		       "DELETE FROM pandamonium_visited_urls WHERE rowid = ?"));
 
-  QSqlDatabase::removeDatabase(pair.second);
+      for(int i = 0; i < rowids.size(); i++)
+	{
+	  query.bindValue(0, rowids.at(i));
+	  query.exec();
+	}
+
+      endTransaction("pandamonium_visited_urls.db");
+    }
 }
 
-void pandamonium_database::saveRequestInterval(const QString &request_interval,
-					       const QVariant &url_hash)
+void pandamonium_database::saveCounters
+(const QHash<QString, quint64> &counters)
 {
-  QPair<QSqlDatabase, QString> pair;
+  if(counters.isEmpty())
+    return;
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
+  if(beginTransaction("pandamonium_statistics.db"))
+    {
+      QHashIterator<QString, quint64> it(counters);
+      QSqlQuery insert
+	(preparedQuery("pandamonium_statistics.db",
+		       "INSERT OR IGNORE INTO pandamonium_counters"
+		       "(name) VALUES(?)"));
+      QSqlQuery update
+	(preparedQuery("pandamonium_statistics.db",
+		       "UPDATE pandamonium_counters "
+		       "SET value = value + ? WHERE name = ?"));
+
+      while(it.hasNext())
+	{
+	  it.next();
+	  insert.bindValue(0, it.key());
+	  insert.exec();
+	  update.bindValue(0, it.value());
+	  update.bindValue(1, it.key());
+	  update.exec();
+	}
+
+      endTransaction("pandamonium_statistics.db");
+    }
+}
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+void pandamonium_database::saveDepthStatistics
+(const QMap<int, QPair<quint64, quint64> > &statistics)
+{
+  if(statistics.isEmpty())
+    return;
 
-	query.prepare("UPDATE pandamonium_search_urls "
-		      "SET request_interval = ? "
-		      "WHERE url_hash = ?");
-	query.bindValue(0, request_interval.toDouble());
-	query.bindValue(1, url_hash.toString());
-	query.exec();
-      }
+  if(beginTransaction("pandamonium_statistics.db"))
+    {
+      QMapIterator<int, QPair<quint64, quint64> > it(statistics);
+      QSqlQuery insert
+	(preparedQuery("pandamonium_statistics.db",
+		       "INSERT OR IGNORE INTO pandamonium_depth_statistics"
+		       "(depth) VALUES(?)"));
+      QSqlQuery update
+	(preparedQuery("pandamonium_statistics.db",
+		       "UPDATE pandamonium_depth_statistics "
+		       "SET discovered = discovered + ?, "
+		       "fetched = fetched + ? "
+		       "WHERE depth = ?"));
+
+      while(it.hasNext())
+	{
+	  it.next();
+	  insert.bindValue(0, it.key());
+	  insert.exec();
+	  update.bindValue(0, it.value().first);
+	  update.bindValue(1, it.value().second);
+	  update.bindValue(2, it.key());
+	  update.exec();
+	}
+
+      endTransaction("pandamonium_statistics.db");
+    }
+}
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+void pandamonium_database::saveGauges(const QHash<QString, quint64> &gauges)
+{
+  if(gauges.isEmpty())
+    return;
 
-  QSqlDatabase::removeDatabase(pair.second);
+  if(beginTransaction("pandamonium_statistics.db"))
+    {
+      QHashIterator<QString, quint64> it(gauges);
+      QSqlQuery query
+	(preparedQuery("pandamonium_statistics.db",
+		       "INSERT OR REPLACE INTO pandamonium_counters"
+		       "(name, value) VALUES(?, ?)"));
+
+      while(it.hasNext())
+	{
+	  it.next();
+	  query.bindValue(0, it.key());
+	  query.bindValue(1, it.value());
+	  query.exec();
+	}
+
+      endTransaction("pandamonium_statistics.db");
+    }
 }
 
-void pandamonium_database::saveSearchDepth(const QString &search_depth,
+void pandamonium_database::saveHostStatistics
+(const QHash<QString, QPair<quint64, quint64> > &statistics)
+{
+  if(statistics.isEmpty())
+    return;
+
+  if(beginTransaction("pandamonium_statistics.db"))
+    {
+      QHashIterator<QString, QPair<quint64, quint64> > it(statistics);
+      QSqlQuery insert
+	(preparedQuery("pandamonium_statistics.db",
+		       "INSERT OR IGNORE INTO pandamonium_host_statistics"
+		       "(host) VALUES(?)"));
+      QSqlQuery update
+	(preparedQuery("pandamonium_statistics.db",
+		       "UPDATE pandamonium_host_statistics "
+		       "SET decoded_bytes = decoded_bytes + ?, "
+		       "wire_bytes = wire_bytes + ? "
+		       "WHERE host = ?"));
+
+      while(it.hasNext())
+	{
+	  it.next();
+	  insert.bindValue(0, it.key());
+	  insert.exec();
+	  update.bindValue(0, it.value().first);
+	  update.bindValue(1, it.value().second);
+	  update.bindValue(2, it.key());
+	  update.exec();
+	}
+
+      endTransaction("pandamonium_statistics.db");
+    }
+}
+
+void pandamonium_database::saveConcurrency(const QString &concurrency,
 					   const QVariant &url_hash)
 {
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db(connection("pandamonium_search_urls.db"));
 
-  {
-    pair = database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.prepare("UPDATE pandamonium_search_urls "
+		    "SET concurrency = ? "
+		    "WHERE url_hash = ?");
+      query.bindValue(0, concurrency.toInt());
+      query.bindValue(1, url_hash.toLongLong());
+      query.exec();
+    }
+}
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
+void pandamonium_database::saveRequestInterval(const QString &request_interval,
+					       const QVariant &url_hash)
+{
+  QSqlDatabase db(connection("pandamonium_search_urls.db"));
 
-	query.prepare("UPDATE pandamonium_search_urls "
-		      "SET search_depth = ? "
-		      "WHERE url_hash = ?");
-	query.bindValue(0, search_depth.toInt());
-	query.bindValue(1, url_hash.toString());
-	query.exec();
-      }
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.prepare("UPDATE pandamonium_search_urls "
+		    "SET request_interval = ? "
+		    "WHERE url_hash = ?");
+      query.bindValue(0, request_interval.toDouble());
+      query.bindValue(1, url_hash.toLongLong());
+      query.exec();
+    }
+}
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+void pandamonium_database::saveSearchDepth(const QString &search_depth,
+					   const QVariant &url_hash)
+{
+  QSqlDatabase db(connection("pandamonium_search_urls.db"));
 
-  QSqlDatabase::removeDatabase(pair.second);
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.prepare("UPDATE pandamonium_search_urls "
+		    "SET search_depth = ? "
+		    "WHERE url_hash = ?");
+      query.bindValue(0, search_depth.toInt());
+      query.bindValue(1, url_hash.toLongLong());
+      query.exec();
+    }
 }
 
 void pandamonium_database::saveUrlMetaData(const QByteArray &content,
+					   const QByteArray &content_hash,
+					   const QByteArray &etag,
+					   const QByteArray &last_modified,
 					   const QString &description,
 					   const QString &title,
 					   const QUrl &url)
@@ -1043,40 +2140,113 @@ void pandamonium_database::saveUrlMetaData(const QByteArray &content,
   if(fileInfo.size() >= pandamonium_common::maximum_database_size)
     return;
 
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = database();
-    pair.first.setDatabaseName(fileInfo.absoluteFilePath());
-
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-
-	query.prepare("INSERT OR REPLACE INTO pandamonium_parsed_urls"
-		      "(content, description, time_inserted, title, url)"
-		      "VALUES(?, ?, ?, ?, ?)");
-	query.bindValue(0, content);
-
-	if(description.trimmed().isEmpty())
-	  query.bindValue(1, pandamonium_common::toEncoded(url));
-	else
-	  query.bindValue(1, description.trimmed());
-
-	query.bindValue(2, QDateTime::currentDateTime().toTime_t());
-
-	if(title.trimmed().isEmpty())
-	  query.bindValue(3, pandamonium_common::toEncoded(url));
-	else
-	  query.bindValue(3, title.trimmed());
+  QSqlDatabase db(connection(fileInfo.absoluteFilePath()));
 
+  if(db.isOpen())
+    {
+      QByteArray contentHash(content_hash);
+      QSqlQuery query(db);
+      qint64 changes = 0;
+      qint64 first = 0;
+      qint64 interval = 0;
+      qint64 now = static_cast<qint64>
+	(QDateTime::currentDateTime().toTime_t());
+      qint64 time_changed = now;
+      qint64 visits = 1;
+
+      /*
+      ** Revisits which reveal new content hashes are counted as
+      ** changes. Partial bodies lack content hashes. Their revisits
+      ** are not counted. The first content hash begins the estimate.
+      */
+
+      QByteArray bytes(pandamonium_common::toEncoded(url));
+      qint64 hash = urlHash(bytes);
+
+      query.setForwardOnly(true);
+      query.prepare("SELECT changes, content_hash, time_changed, "
+		    "time_first, visits "
+		    "FROM pandamonium_parsed_urls "
+		    "WHERE url_hash = ? AND url = ?");
+      query.bindValue(0, hash);
+      query.bindValue(1, bytes);
+
+      if(query.exec() && query.next())
+	{
+	  if(content_hash.isEmpty())
+	    {
+	      changes = query.value(0).toLongLong();
+	      contentHash = query.value(1).toByteArray();
+	      first = query.value(3).toLongLong();
+	      time_changed = query.value(2).toLongLong();
+	      visits = query.value(4).toLongLong();
+	    }
+	  else if(!query.value(1).toByteArray().isEmpty())
+	    {
+	      changes = query.value(0).toLongLong();
+	      first = query.value(3).toLongLong();
+	      visits = query.value(4).toLongLong() + 1;
+
+	      if(query.value(1).toByteArray() != content_hash)
+		changes += 1;
+	      else
+		time_changed = query.value(2).toLongLong();
+	    }
+	}
+      else if(isHashCollision(fileInfo.absoluteFilePath(),
+			      "pandamonium_parsed_urls",
+			      hash,
+			      bytes))
+	return;
+
+      if(first <= 0)
+	first = now;
+
+      interval = changeInterval(changes, visits, now - first);
+      query.finish();
+      query.prepare("INSERT OR REPLACE INTO pandamonium_parsed_urls"
+		    "(change_interval, changes, content, content_hash, "
+		    "description, etag, last_modified, time_changed, "
+		    "time_due, time_first, time_inserted, time_validated, "
+		    "title, url, url_hash, visits)"
+		    "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+      query.bindValue(0, interval);
+      query.bindValue(1, changes);
+      query.bindValue(2, content);
+      if(contentHash.isEmpty())
+	query.bindValue(3, QVariant(QVariant::String));
+      else
+	query.bindValue(3, contentHash);
+
+      if(description.trimmed().isEmpty())
 	query.bindValue(4, pandamonium_common::toEncoded(url));
-	query.exec();
-      }
-
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
-
-  QSqlDatabase::removeDatabase(pair.second);
+      else
+	query.bindValue(4, description.trimmed());
+
+      if(etag.trimmed().isEmpty())
+	query.bindValue(5, QVariant(QVariant::String));
+      else
+	query.bindValue(5, etag.trimmed());
+
+      if(last_modified.trimmed().isEmpty())
+	query.bindValue(6, QVariant(QVariant::String));
+      else
+	query.bindValue(6, last_modified.trimmed());
+
+      query.bindValue(7, time_changed);
+      query.bindValue(8, now + interval);
+      query.bindValue(9, first);
+      query.bindValue(10, now);
+      query.bindValue(11, now);
+
+      if(title.trimmed().isEmpty())
+	query.bindValue(12, pandamonium_common::toEncoded(url));
+      else
+	query.bindValue(12, title.trimmed());
+
+      query.bindValue(13, bytes);
+      query.bindValue(14, hash);
+      query.bindValue(15, visits);
+      query.exec();
+    }
 }
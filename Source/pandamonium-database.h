@@ -28,44 +28,89 @@
 #ifndef _pandamonium_database_h_
 #define _pandamonium_database_h_
 
+#include <QAtomicInt>
+#include <QHash>
+#include <QMap>
 #include <QPair>
 #include <QReadWriteLock>
 #include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QUrl>
 
 class pandamonium_database
 {
  public:
   static QHash<QString, QString> exportDefinition(void);
+  static QHash<QString, quint64> counters(void);
+  static QList<QList<QVariant> > depthStatistics(void);
+  static QList<QList<QVariant> > dueUrls(const qint64 now,
+					 QPair<qint64, qint64> &cursor,
+					 const int limit);
   static QList<QList<QVariant> > parsedLinks(const quint64 limit,
 					     const quint64 offset);
   static QList<QList<QVariant> > searchUrls(void);
+  static QList<QList<QVariant> > visitedUrls(const int limit);
   static QPair<QSqlDatabase, QString> database(void);
+  static QPair<QList<qint64>, qint64> visitedUrlHashes(const qint64 rowid,
+						      const int limit);
+  static QPair<QList<QPair<QUrl, qint64> >, qint64> unvisitedChildUrls
+    (const int depth, const qint64 rowid, const int limit);
+  static QPair<quint64, qint64> visitedUrlsExtent(void);
   static QPair<quint64, quint64> unvisitedAndVisitedNumbers(void);
-  static QUrl unvisitedChildUrl(void);
+  static QPair<quint64, quint64> visitedUrlsCounts(void);
+  static QSqlDatabase connection(const QString &fileName);
+  static QSqlQuery preparedQuery(const QString &fileName,
+				 const QString &statement);
+  static bool beginTransaction(const QString &fileName);
+  static bool endTransaction(const QString &fileName);
+  static bool invalidateReplacedDatabases(void);
   static bool isKernelActive(void);
-  static bool isUrlMetaDataOnly(const QUrl &url);
+  static bool isUrlParsed(const QUrl &url);
   static bool saveExportDefinition(const QHash<QString, QString> &hash);
   static bool shouldTerminateKernel(const qint64 process_id);
+  static int minimumUnvisitedDepth(const int depth);
   static qint64 kernelProcessId(void);
   static qint64 parsedLinksCount(void);
+  static quint64 markUrlsAsUnvisited(const QList<QUrl> &urls,
+				     const int depth,
+				     const qint64 seed);
   static void addSearchUrl(const QString &str);
+  static void checkpoint(void);
   static void createdb(void);
+  static void disableAutomaticCheckpoints(void);
   static void exportUrl(const QString &str, const bool shouldDelete);
-  static void markUrlAsVisited(const QUrl &url, const bool visited);
+  static void invalidate(const QString &fileName);
+  static void markUrlAsValidated(const QUrl &url);
+  static void markUrlsAsModified(const QList<QPair<QUrl, qint64> > &list);
+  static void markUrlAsVisited(const QUrl &url,
+			       const bool visited,
+			       const int depth);
   static void recordBrokenUrl(const QString &error_string,
 			      const QUrl &child_url,
 			      const QUrl &parent_url);
   static void recordKernelDeactivation(const qint64 process_id = 0);
   static void recordKernelProcessId(const qint64 process_id);
+  static void remove(const QString &fileName);
   static void removeBrokenUrls(const QStringList &list);
   static void removeParsedUrls(const QStringList &list);
   static void removeSearchUrls(const QStringList &list);
+  static void removeVisitedUrls(const QList<qint64> &rowids);
+  static void saveCounters(const QHash<QString, quint64> &counters);
+  static void saveDepthStatistics
+    (const QMap<int, QPair<quint64, quint64> > &statistics);
+  static void saveGauges(const QHash<QString, quint64> &gauges);
+  static void saveHostStatistics
+    (const QHash<QString, QPair<quint64, quint64> > &statistics);
+  static void saveConcurrency(const QString &concurrency,
+			      const QVariant &url_hash);
   static void saveRequestInterval(const QString &request_interval,
 				  const QVariant &url_hash);
   static void saveSearchDepth(const QString &search_depth,
 			      const QVariant &url_hash);
   static void saveUrlMetaData(const QByteArray &content,
+			      const QByteArray &content_hash,
+			      const QByteArray &etag,
+			      const QByteArray &last_modified,
 			      const QString &description,
 			      const QString &title,
 			      const QUrl &url);
@@ -75,8 +120,29 @@ class pandamonium_database
   {
   }
 
+  static QAtomicInt s_automaticCheckpoints;
+  static QHash<QString, qint64> s_identities;
+  static QHash<QString, quint64> s_generations;
   static QReadWriteLock s_dbIdLock;
+  static QReadWriteLock s_generationsLock;
   static quint64 s_dbId;
+  static QString absoluteFileName(const QString &fileName);
+  static QStringList fileNames(void);
+  static QStringList pragmas(void);
+  static bool isHashCollision(const QString &fileName,
+			      const QString &table,
+			      const qint64 hash,
+			      const QByteArray &url);
+  static qint64 changeInterval(const qint64 changes,
+				const qint64 visits,
+				const qint64 window);
+  static qint64 identity(const QString &fileName);
+  static qint64 urlHash(const QByteArray &bytes);
+  static quint64 generation(const QString &fileName);
+  static void migrateUrlKeys(const QString &fileName,
+			     const QString &table,
+			     const QString &statement,
+			     const bool rowids);
 };
 
 #endif
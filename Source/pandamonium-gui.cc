@@ -471,6 +471,25 @@ void pandamonium_gui::gatherStatistics(void)
 	     << static_cast<qint64> (percent)
 	     << numbers.first
 	     << numbers.first + numbers.second;
+
+  QHash<QString, quint64> counters(pandamonium_database::counters());
+
+  statistics << counters.value("canonical_collapsed")
+	     << counters.value("canonical_rewritten")
+	     << counters.value("filter_rejected")
+	     << counters.value("filter_false_positive_ppm")
+	     << counters.value("url_store_urls")
+	     << counters.value("url_store_bytes") / 1024;
+
+  /*
+  ** Per-depth statistics.
+  */
+
+  QList<QList<QVariant> > list(pandamonium_database::depthStatistics());
+
+  for(int i = 0; i < list.size(); i++)
+    statistics << QVariant(list.at(i));
+
   emit statisticsReady(statistics);
 }
 
@@ -479,63 +498,53 @@ void pandamonium_gui::populateBroken(void)
   QApplication::setOverrideCursor(Qt::BusyCursor);
   m_uiBrokenLinks.table->setRowCount(0);
 
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db
+    (pandamonium_database::connection("pandamonium_broken_urls.db"));
 
-  {
-    pair = pandamonium_database::database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_broken_urls.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+      int row = 0;
+      quint64 limit = static_cast<quint64> (m_uiBrokenLinks.
+					    page_limit->currentText().
+					    toInt());
+      quint64 offset = static_cast<quint64> (limit * m_uiBrokenLinks.
+					     page->currentIndex());
+
+      m_uiBrokenLinks.table->setSortingEnabled(false);
+      query.setForwardOnly(true);
+      query.prepare
+	(QString("SELECT url_parent, url, error_string, url_hash "
+		 "FROM pandamonium_broken_urls ORDER BY url_parent "
+		 "LIMIT %1 OFFSET %2").arg(limit).arg(offset));
+
+      if(query.exec())
+	while(query.next())
+	  {
+	    m_uiBrokenLinks.table->setRowCount(row + 1);
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-	int row = 0;
-	quint64 limit = static_cast<quint64> (m_uiBrokenLinks.
-					      page_limit->currentText().
-					      toInt());
-	quint64 offset = static_cast<quint64> (limit * m_uiBrokenLinks.
-					       page->currentIndex());
-
-	m_uiBrokenLinks.table->setSortingEnabled(false);
-	query.setForwardOnly(true);
-	query.prepare
-	  (QString("SELECT url_parent, url, error_string, url_hash "
-		   "FROM pandamonium_broken_urls ORDER BY url_parent "
-		   "LIMIT %1 OFFSET %2").arg(limit).arg(offset));
-
-	if(query.exec())
-	  while(query.next())
-	    {
-	      m_uiBrokenLinks.table->setRowCount(row + 1);
-
-	      QTableWidgetItem *item = 0;
-
-	      item = new QTableWidgetItem(query.value(0).toString());
-	      item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-	      m_uiBrokenLinks.table->setItem(row, 0, item);
-	      item = new QTableWidgetItem(query.value(1).toString());
-	      item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-	      m_uiBrokenLinks.table->setItem(row, 1, item);
-	      item = new QTableWidgetItem(query.value(2).toString());
-	      item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-	      m_uiBrokenLinks.table->setItem(row, 2, item);
-	      item = new QTableWidgetItem(query.value(3).toString());
-	      item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-	      m_uiBrokenLinks.table->setItem(row, 3, item);
-	      row += 1;
-	    }
-
-	m_uiBrokenLinks.table->setSortingEnabled(true);
-	m_uiBrokenLinks.table->horizontalHeader()->
-	  setSortIndicator(0, Qt::AscendingOrder);
-      }
+	    QTableWidgetItem *item = 0;
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+	    item = new QTableWidgetItem(query.value(0).toString());
+	    item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+	    m_uiBrokenLinks.table->setItem(row, 0, item);
+	    item = new QTableWidgetItem(query.value(1).toString());
+	    item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+	    m_uiBrokenLinks.table->setItem(row, 1, item);
+	    item = new QTableWidgetItem(query.value(2).toString());
+	    item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+	    m_uiBrokenLinks.table->setItem(row, 2, item);
+	    item = new QTableWidgetItem(query.value(3).toString());
+	    item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+	    m_uiBrokenLinks.table->setItem(row, 3, item);
+	    row += 1;
+	  }
+
+      m_uiBrokenLinks.table->setSortingEnabled(true);
+      m_uiBrokenLinks.table->horizontalHeader()->
+	setSortIndicator(0, Qt::AscendingOrder);
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
   QApplication::restoreOverrideCursor();
 }
 
@@ -737,6 +746,16 @@ void pandamonium_gui::slotAddSearchUrl(void)
   slotListSearchUrls();
 }
 
+void pandamonium_gui::slotConcurrencyChanged(const QString &text)
+{
+  QSpinBox *spinBox = qobject_cast<QSpinBox *> (sender());
+
+  if(!spinBox)
+    return;
+
+  pandamonium_database::saveConcurrency(text, spinBox->property("url_hash"));
+}
+
 void pandamonium_gui::slotCopySelectedURL(void)
 {
   QClipboard *clipboard = QApplication::clipboard();
@@ -945,6 +964,29 @@ void pandamonium_gui::slotExportTableSelected(void)
   QSqlDatabase::removeDatabase(pair.second);
 }
 
+void pandamonium_gui::slotHeadOnly(bool state)
+{
+  QCheckBox *checkBox = qobject_cast<QCheckBox *> (sender());
+
+  if(!checkBox)
+    return;
+
+  QSqlDatabase db
+    (pandamonium_database::connection("pandamonium_search_urls.db"));
+
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.prepare("UPDATE pandamonium_search_urls "
+		    "SET head_only = ? "
+		    "WHERE url_hash = ?");
+      query.bindValue(0, state ? 1 : 0);
+      query.bindValue(1, checkBox->property("url_hash"));
+      query.exec();
+    }
+}
+
 void pandamonium_gui::slotHighlightTimeout(void)
 {
   QColor color;
@@ -1053,153 +1095,186 @@ void pandamonium_gui::slotListSearchUrls(void)
 
   m_ui.search_urls->setRowCount(0);
 
-  QPair<QSqlDatabase, QString> pair;
+  QSqlDatabase db
+    (pandamonium_database::connection("pandamonium_search_urls.db"));
 
-  {
-    pair = pandamonium_database::database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+      int row = 0;
 
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-	int row = 0;
-
-	query.setForwardOnly(true);
-
-	if(query.exec("SELECT meta_data_only, paused, request_interval, "
-		      "search_depth, url, url_hash "
-		      "FROM pandamonium_search_urls "
-		      "ORDER BY url"))
-	  while(query.next())
-	    {
-	      m_ui.search_urls->setRowCount(row + 1);
-
-	      for(int i = 0; i < query.record().count(); i++)
-		{
-		  if(i == 0)
-		    {
-		      QCheckBox *checkBox = new QCheckBox();
-
-		      checkBox->setChecked(query.value(i).toInt());
-		      checkBox->setProperty
-			("url_hash", query.value(query.record().count() - 1));
-		      checkBox->setToolTip
-			(tr("If enabled, only meta-data words will "
-			    "be saved. "
-			    "Otherwise, all site words will be saved."));
-		      connect(checkBox,
-			      SIGNAL(toggled(bool)),
-			      this,
-			      SLOT(slotMetaDataOnly(bool)));
-		      m_ui.search_urls->setCellWidget(row, i, checkBox);
-		    }
-		  else if(i == 1)
-		    {
-		      QCheckBox *checkBox = new QCheckBox();
-
-		      checkBox->setChecked(query.value(i).toInt());
-		      checkBox->setProperty
-			("url_hash", query.value(query.record().count() - 1));
-		      connect(checkBox,
-			      SIGNAL(toggled(bool)),
-			      this,
-			      SLOT(slotPause(bool)));
-		      m_ui.search_urls->setCellWidget(row, i, checkBox);
-		    }
-		  else if(i == 2)
-		    {
-		      QDoubleSpinBox *spinBox = new QDoubleSpinBox();
-
-		      spinBox->setMaximum(100.00);
-		      spinBox->setMinimum(0.100);
-		      spinBox->setValue(query.value(i).toDouble());
-		      spinBox->setProperty
-			("url_hash", query.value(query.record().count() - 1));
-		      connect(spinBox,
-			      SIGNAL(valueChanged(const QString &)),
-			      this,
-			      SLOT(slotLoadIntervalChanged(const QString &)));
-		      m_ui.search_urls->setCellWidget(row, i, spinBox);
-		    }
-		  else if(i == 3)
-		    {
-		      QComboBox *comboBox = new QComboBox();
-		      int index = 0;
-
-		      comboBox->addItem("-1");
-		      comboBox->setProperty
-			("url_hash", query.value(query.record().count() - 1));
-		      index = comboBox->findText(query.value(i).toString());
-
-		      if(index >= 0)
-			comboBox->setCurrentIndex(index);
-
-		      connect(comboBox,
-			      SIGNAL(currentIndexChanged(const QString &)),
-			      this,
-			      SLOT(slotDepthChanged(const QString &)));
-		      m_ui.search_urls->setCellWidget(row, i, comboBox);
-		    }
-		  else if(i == 4)
-		    {
-		      QTableWidgetItem *item = new QTableWidgetItem
-			(QUrl::fromEncoded(query.value(i).toByteArray()).
-			 toString());
-
-		      item->setFlags
-			(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-		      m_ui.search_urls->setItem(row, i, item);
-
-		      if(i == query.record().count() - 1)
-			if(selected.contains(item->text()))
-			  {
-			    QModelIndex index
-			      (m_ui.search_urls->model()->index(row, 0));
-
-			    m_ui.search_urls->selectionModel()->select
-			      (index,
-			       QItemSelectionModel::Rows |
-			       QItemSelectionModel::SelectCurrent);
-			  }
-		    }
-		  else
-		    {
-		      QTableWidgetItem *item = new QTableWidgetItem
-			(query.value(i).toString());
-
-		      item->setFlags
-			(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-		      m_ui.search_urls->setItem(row, i, item);
-
-		      if(i == query.record().count() - 1)
-			if(selected.contains(item->text()))
-			  {
-			    QModelIndex index
-			      (m_ui.search_urls->model()->index(row, 0));
-
-			    m_ui.search_urls->selectionModel()->select
-			      (index,
-			       QItemSelectionModel::Rows |
-			       QItemSelectionModel::SelectCurrent);
-			  }
-		    }
-		}
-
-	      row += 1;
-	    }
-
-	m_ui.search_urls->resizeColumnToContents(0);
-	m_ui.search_urls->resizeColumnToContents(1);
-	m_ui.search_urls->resizeColumnToContents(2);
-      }
+      query.setForwardOnly(true);
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+      if(query.exec("SELECT concurrency, head_only, meta_data_only, "
+		    "paused, request_interval, search_depth, url, url_hash "
+		    "FROM pandamonium_search_urls "
+		    "ORDER BY url"))
+	while(query.next())
+	  {
+	    m_ui.search_urls->setRowCount(row + 1);
+
+	    for(int i = 0; i < query.record().count(); i++)
+	      {
+		if(i == 0)
+		  {
+		    QSpinBox *spinBox = new QSpinBox();
+
+		    spinBox->setMaximum(16);
+		    spinBox->setMinimum(1);
+		    spinBox->setValue(query.value(i).toInt());
+		    spinBox->setProperty
+		      ("url_hash", query.value(query.record().count() - 1));
+		    spinBox->setToolTip
+		      (tr("The maximum number of outstanding requests."));
+		    connect(spinBox,
+			    SIGNAL(valueChanged(const QString &)),
+			    this,
+			    SLOT(slotConcurrencyChanged(const QString &)));
+		    m_ui.search_urls->setCellWidget(row, i, spinBox);
+		  }
+		else if(i == 1)
+		  {
+		    QCheckBox *checkBox = new QCheckBox();
+
+		    checkBox->setChecked(query.value(i).toInt());
+		    checkBox->setProperty
+		      ("url_hash", query.value(query.record().count() - 1));
+		    checkBox->setToolTip
+		      (tr("If enabled, only the heads of meta-data-only "
+			  "pages are downloaded. Links which follow the "
+			  "heads are not discovered."));
+		    connect(checkBox,
+			    SIGNAL(toggled(bool)),
+			    this,
+			    SLOT(slotHeadOnly(bool)));
+		    m_ui.search_urls->setCellWidget(row, i, checkBox);
+		  }
+		else if(i == 2)
+		  {
+		    QCheckBox *checkBox = new QCheckBox();
+
+		    checkBox->setChecked(query.value(i).toInt());
+		    checkBox->setProperty
+		      ("url_hash", query.value(query.record().count() - 1));
+		    checkBox->setToolTip
+		      (tr("If enabled, only meta-data words will "
+			  "be saved. "
+			  "Otherwise, all site words will be saved."));
+		    connect(checkBox,
+			    SIGNAL(toggled(bool)),
+			    this,
+			    SLOT(slotMetaDataOnly(bool)));
+		    m_ui.search_urls->setCellWidget(row, i, checkBox);
+		  }
+		else if(i == 3)
+		  {
+		    QCheckBox *checkBox = new QCheckBox();
+
+		    checkBox->setChecked(query.value(i).toInt());
+		    checkBox->setProperty
+		      ("url_hash", query.value(query.record().count() - 1));
+		    connect(checkBox,
+			    SIGNAL(toggled(bool)),
+			    this,
+			    SLOT(slotPause(bool)));
+		    m_ui.search_urls->setCellWidget(row, i, checkBox);
+		  }
+		else if(i == 4)
+		  {
+		    QDoubleSpinBox *spinBox = new QDoubleSpinBox();
+
+		    spinBox->setMaximum(100.00);
+		    spinBox->setMinimum(0.100);
+		    spinBox->setValue(query.value(i).toDouble());
+		    spinBox->setProperty
+		      ("url_hash", query.value(query.record().count() - 1));
+		    connect(spinBox,
+			    SIGNAL(valueChanged(const QString &)),
+			    this,
+			    SLOT(slotLoadIntervalChanged(const QString &)));
+		    m_ui.search_urls->setCellWidget(row, i, spinBox);
+		  }
+		else if(i == 5)
+		  {
+		    QComboBox *comboBox = new QComboBox();
+		    int index = 0;
+
+		    comboBox->addItem("-1");
+
+		    for(int j = 0; j <= 10; j++)
+		      comboBox->addItem(QString::number(j));
+
+		    comboBox->setToolTip
+		      (tr("The maximum depth of discovered links. "
+			  "A depth of -1 is infinite."));
+		    comboBox->setProperty
+		      ("url_hash", query.value(query.record().count() - 1));
+		    index = comboBox->findText(query.value(i).toString());
+
+		    if(index >= 0)
+		      comboBox->setCurrentIndex(index);
+
+		    connect(comboBox,
+			    SIGNAL(currentIndexChanged(const QString &)),
+			    this,
+			    SLOT(slotDepthChanged(const QString &)));
+		    m_ui.search_urls->setCellWidget(row, i, comboBox);
+		  }
+		else if(i == 6)
+		  {
+		    QTableWidgetItem *item = new QTableWidgetItem
+		      (QUrl::fromEncoded(query.value(i).toByteArray()).
+		       toString());
+
+		    item->setFlags
+		      (Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+		    m_ui.search_urls->setItem(row, i, item);
+
+		    if(i == query.record().count() - 1)
+		      if(selected.contains(item->text()))
+			{
+			  QModelIndex index
+			    (m_ui.search_urls->model()->index(row, 0));
+
+			  m_ui.search_urls->selectionModel()->select
+			    (index,
+			     QItemSelectionModel::Rows |
+			     QItemSelectionModel::SelectCurrent);
+			}
+		  }
+		else
+		  {
+		    QTableWidgetItem *item = new QTableWidgetItem
+		      (query.value(i).toString());
+
+		    item->setFlags
+		      (Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+		    m_ui.search_urls->setItem(row, i, item);
+
+		    if(i == query.record().count() - 1)
+		      if(selected.contains(item->text()))
+			{
+			  QModelIndex index
+			    (m_ui.search_urls->model()->index(row, 0));
+
+			  m_ui.search_urls->selectionModel()->select
+			    (index,
+			     QItemSelectionModel::Rows |
+			     QItemSelectionModel::SelectCurrent);
+			}
+		  }
+	      }
+
+	    row += 1;
+	  }
+
+      m_ui.search_urls->resizeColumnToContents(0);
+      m_ui.search_urls->resizeColumnToContents(1);
+      m_ui.search_urls->resizeColumnToContents(2);
+      m_ui.search_urls->resizeColumnToContents(3);
+      m_ui.search_urls->resizeColumnToContents(4);
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
   QApplication::restoreOverrideCursor();
 }
 
@@ -1221,31 +1296,20 @@ void pandamonium_gui::slotMetaDataOnly(bool state)
   if(!checkBox)
     return;
 
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = pandamonium_database::database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
-
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-
-	query.prepare("UPDATE pandamonium_search_urls "
-		      "SET meta_data_only = ? "
-		      "WHERE url_hash = ?");
-	query.bindValue(0, state ? 1 : 0);
-	query.bindValue(1, checkBox->property("url_hash"));
-	query.exec();
-      }
-
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  QSqlDatabase db
+    (pandamonium_database::connection("pandamonium_search_urls.db"));
 
-  QSqlDatabase::removeDatabase(pair.second);
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.prepare("UPDATE pandamonium_search_urls "
+		    "SET meta_data_only = ? "
+		    "WHERE url_hash = ?");
+      query.bindValue(0, state ? 1 : 0);
+      query.bindValue(1, checkBox->property("url_hash"));
+      query.exec();
+    }
 }
 
 void pandamonium_gui::slotMonitorKernel(bool state)
@@ -1278,31 +1342,20 @@ void pandamonium_gui::slotPause(bool state)
   if(!checkBox)
     return;
 
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = pandamonium_database::database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_search_urls.db");
-
-    if(pair.first.open())
-      {
-	QSqlQuery query(pair.first);
-
-	query.prepare("UPDATE pandamonium_search_urls "
-		      "SET paused = ? "
-		      "WHERE url_hash = ?");
-	query.bindValue(0, state ? 1 : 0);
-	query.bindValue(1, checkBox->property("url_hash"));
-	query.exec();
-      }
-
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+  QSqlDatabase db
+    (pandamonium_database::connection("pandamonium_search_urls.db"));
 
-  QSqlDatabase::removeDatabase(pair.second);
+  if(db.isOpen())
+    {
+      QSqlQuery query(db);
+
+      query.prepare("UPDATE pandamonium_search_urls "
+		    "SET paused = ? "
+		    "WHERE url_hash = ?");
+      query.bindValue(0, state ? 1 : 0);
+      query.bindValue(1, checkBox->property("url_hash"));
+      query.exec();
+    }
 }
 
 void pandamonium_gui::slotProxyInformationToggled(bool state)
@@ -1340,46 +1393,36 @@ void pandamonium_gui::slotRefreshBrokenUrls(void)
 {
   QApplication::setOverrideCursor(Qt::BusyCursor);
 
-  QPair<QSqlDatabase, QString> pair;
-
-  {
-    pair = pandamonium_database::database();
-    pair.first.setDatabaseName
-      (pandamonium_common::homePath() + QDir::separator() +
-       "pandamonium_broken_urls.db");
-
-    if(pair.first.open())
-      {
-	m_uiBrokenLinks.page->clear();
+  QSqlDatabase db
+    (pandamonium_database::connection("pandamonium_broken_urls.db"));
 
-	QSqlQuery query(pair.first);
-	quint64 count = 0;
-	quint64 i = 1;
+  if(db.isOpen())
+    {
+      m_uiBrokenLinks.page->clear();
 
-	if(query.exec("SELECT COUNT(*) FROM pandamonium_broken_urls"))
-	  if(query.next())
-	    count = query.value(0).toULongLong();
+      QSqlQuery query(db);
+      quint64 count = 0;
+      quint64 i = 1;
 
-	do
-	  {
-	    m_uiBrokenLinks.page->addItem(tr("Page %1").arg(i));
+      if(query.exec("SELECT COUNT(*) FROM pandamonium_broken_urls"))
+	if(query.next())
+	  count = query.value(0).toULongLong();
 
-	    if(i > count / static_cast<quint64> (m_uiBrokenLinks.
-						 page_limit->
-						 currentText().
-						 toInt()))
-	      break;
+      do
+	{
+	  m_uiBrokenLinks.page->addItem(tr("Page %1").arg(i));
 
-	    i += 1;
-	  }
-	while(true);
-      }
+	  if(i > count / static_cast<quint64> (m_uiBrokenLinks.
+					       page_limit->
+					       currentText().
+					       toInt()))
+	    break;
 
-    pair.first.close();
-    pair.first = QSqlDatabase();
-  }
+	  i += 1;
+	}
+      while(true);
+    }
 
-  QSqlDatabase::removeDatabase(pair.second);
   QApplication::restoreOverrideCursor();
   populateBroken();
 }
@@ -1390,8 +1433,7 @@ void pandamonium_gui::slotRemoveAllBrokenUrls(void)
 		    "the broken links?"), m_brokenLinksWindow))
     return;
 
-  QFile::remove(pandamonium_common::homePath() + QDir::separator() +
-		"pandamonium_broken_urls.db");
+  pandamonium_database::remove("pandamonium_broken_urls.db");
   slotRefreshBrokenUrls();
 }
 
@@ -1401,8 +1443,7 @@ void pandamonium_gui::slotRemoveAllParsedUrls(void)
 		    "the parsed URLs?"), this))
     return;
 
-  QFile::remove(pandamonium_common::homePath() + QDir::separator() +
-		"pandamonium_parsed_urls.db");
+  pandamonium_database::remove("pandamonium_parsed_urls.db");
   slotListParsedUrls();
 }
 
@@ -1500,8 +1541,7 @@ void pandamonium_gui::slotRemoveUnvisitedVisitedUrls(void)
 		    "pandamonium_visited_urls.db?"), this))
     return;
 
-  QFile::remove(pandamonium_common::homePath() + QDir::separator() +
-		"pandamonium_visited_urls.db");
+  pandamonium_database::remove("pandamonium_visited_urls.db");
 }
 
 void pandamonium_gui::slotSaveExportDefinition(void)
@@ -1702,17 +1742,44 @@ void pandamonium_gui::slotStatisticsReady(const QList<QVariant> &statistics)
 	 << "Parsed URLs"
 	 << "Percent Remaining"
 	 << "Remaining URLs"
-	 << "Total URLs Discovered";
+	 << "Total URLs Discovered"
+	 << "Duplicate URLs Collapsed"
+	 << "URLs Canonicalized"
+	 << "Known URLs Filtered"
+	 << "URL Filter False Positives (PPM)"
+	 << "URLs In URL Store"
+	 << "URL Store Size (KiB)";
   values << statistics.value(1).toLongLong()
 	 << statistics.value(2).toLongLong()
 	 << statistics.value(3).toLongLong()
 	 << statistics.value(4).toLongLong()
 	 << statistics.value(5).toLongLong()
-	 << statistics.value(6).toLongLong();
+	 << statistics.value(6).toLongLong()
+	 << statistics.value(7).toLongLong()
+	 << statistics.value(8).toLongLong()
+	 << statistics.value(9).toLongLong()
+	 << statistics.value(10).toLongLong()
+	 << statistics.value(11).toLongLong()
+	 << statistics.value(12).toLongLong();
+
+  for(int i = 13; i < statistics.size(); i++)
+    {
+      QList<QVariant> list(statistics.at(i).toList()); /*
+							 ** 0 - depth
+							 ** 1 - discovered
+							 ** 2 - fetched
+							 */
+
+      labels << QString("URLs Discovered At Depth %1").
+	arg(list.value(0).toInt())
+	     << QString("URLs Fetched At Depth %1").arg(list.value(0).toInt());
+      values << list.value(1).toLongLong()
+	     << list.value(2).toLongLong();
+    }
 
   bool initialize = true;
 
-  if(m_uiStatistics.statistics->rowCount() == 0)
+  if(m_uiStatistics.statistics->rowCount() != labels.size())
     m_uiStatistics.statistics->setRowCount(labels.size());
   else
     initialize = false;
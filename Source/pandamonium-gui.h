@@ -76,6 +76,7 @@ class pandamonium_gui: public QMainWindow
   void slotAbout(void);
   void slotActivateKernel(void);
   void slotAddSearchUrl(void);
+  void slotConcurrencyChanged(const QString &text);
   void slotCopySelectedURL(void);
   void slotCustomContextMenuRequested(const QPoint &point);
   void slotDeactivateKernel(void);
@@ -85,6 +86,7 @@ class pandamonium_gui: public QMainWindow
   void slotExportCheckBoxClicked(bool state);
   void slotExportDefinition(void);
   void slotExportTableSelected(void);
+  void slotHeadOnly(bool state);
   void slotHighlightTimeout(void);
   void slotKernelDatabaseTimeout(void);
   void slotKernelToolButtonClicked(void);
@@ -0,0 +1,212 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QSettings>
+#include <QStringList>
+
+#include <algorithm>
+
+#include "pandamonium-common.h"
+#include "pandamonium-kernel-canonicalizer.h"
+
+static QByteArray join(const QList<QByteArray> &list, const char c)
+{
+  QByteArray bytes;
+
+  for(int i = 0; i < list.size(); i++)
+    {
+      if(i > 0)
+	bytes.append(c);
+
+      bytes.append(list.at(i));
+    }
+
+  return bytes;
+}
+
+static bool sortParameters(const QByteArray &a, const QByteArray &b)
+{
+  return a.mid(0, a.indexOf('=')) < b.mid(0, b.indexOf('='));
+}
+
+pandamonium_kernel_canonicalizer::pandamonium_kernel_canonicalizer(void)
+{
+  QSettings settings;
+  QStringList list
+    (settings.value("pandamonium_canonical_parameters",
+		    "_ga,dclid,fbclid,gclid,mc_cid,mc_eid,msclkid,utm_*").
+     toString().split(','));
+
+  for(int i = 0; i < list.size(); i++)
+    {
+      QByteArray bytes(list.at(i).trimmed().toLower().toUtf8());
+
+      if(!bytes.isEmpty())
+	m_parameters << bytes;
+    }
+
+  m_sortQuery = settings.value("pandamonium_canonical_sort_query", true).
+    toBool();
+}
+
+pandamonium_kernel_canonicalizer::~pandamonium_kernel_canonicalizer()
+{
+}
+
+QByteArray pandamonium_kernel_canonicalizer::removeDotSegments
+(const QByteArray &path)
+{
+  /*
+  ** RFC 3986, section 5.2.4.
+  */
+
+  if(!path.contains("/.") && !path.startsWith('.'))
+    return path.isEmpty() ? QByteArray("/") : path;
+
+  QList<QByteArray> input(path.split('/'));
+  QList<QByteArray> output;
+  bool directory = false;
+
+  for(int i = 0; i < input.size(); i++)
+    {
+      const QByteArray &segment(input.at(i));
+
+      directory = false;
+
+      if(segment == ".")
+	directory = true;
+      else if(segment == "..")
+	{
+	  if(output.size() > 1)
+	    output.removeLast();
+
+	  directory = true;
+	}
+      else
+	output << segment;
+    }
+
+  if(directory)
+    output << QByteArray();
+
+  QByteArray bytes(join(output, '/'));
+
+  if(!bytes.startsWith('/'))
+    bytes.prepend('/');
+
+  return bytes;
+}
+
+QUrl pandamonium_kernel_canonicalizer::canonicalize(const QUrl &url) const
+{
+  if(url.isEmpty() || !url.isValid() || url.host().isEmpty())
+    return url;
+
+  QString scheme(url.scheme().toLower());
+  QUrl u(url);
+
+  u.setFragment(QString());
+  u.setHost(url.host().toLower());
+  u.setScheme(scheme);
+
+  if((scheme == "http" && u.port() == 80) ||
+     (scheme == "https" && u.port() == 443))
+    u.setPort(-1);
+
+  /*
+  ** The path and the query are processed in their encoded forms.
+  */
+
+  QByteArray bytes(pandamonium_common::toEncoded(u));
+  int index = bytes.indexOf("://");
+
+  if(index < 0)
+    return u;
+
+  int start = index + 3;
+
+  while(start < bytes.length() && bytes.at(start) != '/' &&
+	bytes.at(start) != '?')
+    start += 1;
+
+  QByteArray authority(bytes.mid(0, start));
+  QByteArray path;
+  QByteArray query;
+
+  index = bytes.indexOf('?', start);
+
+  if(index < 0)
+    path = bytes.mid(start);
+  else
+    {
+      path = bytes.mid(start, index - start);
+      query = bytes.mid(index + 1);
+    }
+
+  QList<QByteArray> parameters;
+
+  foreach(const QByteArray &parameter, query.split('&'))
+    if(!parameter.isEmpty() && !isRemovable(parameter))
+      parameters << parameter;
+
+  if(m_sortQuery)
+    std::stable_sort(parameters.begin(), parameters.end(), sortParameters);
+
+  bytes = authority + removeDotSegments(path);
+
+  if(!parameters.isEmpty())
+    bytes.append('?').append(join(parameters, '&'));
+
+  QUrl canonical(QUrl::fromEncoded(bytes));
+
+  if(canonical.isEmpty() || !canonical.isValid())
+    return u;
+
+  return canonical;
+}
+
+bool pandamonium_kernel_canonicalizer::isRemovable
+(const QByteArray &parameter) const
+{
+  int index = parameter.indexOf('=');
+  QByteArray name(parameter.mid(0, index).toLower());
+
+  for(int i = 0; i < m_parameters.size(); i++)
+    {
+      const QByteArray &bytes(m_parameters.at(i));
+
+      if(bytes.endsWith('*'))
+	{
+	  if(name.startsWith(bytes.mid(0, bytes.length() - 1)))
+	    return true;
+	}
+      else if(name == bytes)
+	return true;
+    }
+
+  return false;
+}
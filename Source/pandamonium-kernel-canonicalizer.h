@@ -0,0 +1,58 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_canonicalizer_h_
+#define _pandamonium_kernel_canonicalizer_h_
+
+#include <QByteArray>
+#include <QList>
+#include <QUrl>
+
+/*
+** Canonical URLs: lowercase schemes and hosts, no default ports, no
+** fragments, no dot segments, and no tracking parameters. The names
+** of the removed parameters are listed in
+** pandamonium_canonical_parameters; a trailing * matches prefixes. The
+** remaining parameters are sorted by name unless
+** pandamonium_canonical_sort_query is false.
+*/
+
+class pandamonium_kernel_canonicalizer
+{
+ public:
+  pandamonium_kernel_canonicalizer(void);
+  ~pandamonium_kernel_canonicalizer();
+  QUrl canonicalize(const QUrl &url) const;
+
+ private:
+  QList<QByteArray> m_parameters;
+  bool m_sortQuery;
+  bool isRemovable(const QByteArray &parameter) const;
+  static QByteArray removeDotSegments(const QByteArray &path);
+};
+
+#endif
@@ -0,0 +1,215 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+
+#include "pandamonium-kernel-decoder.h"
+
+static const int s_bufferSize = 16384;
+
+pandamonium_kernel_decoder::pandamonium_kernel_decoder
+(const QByteArray &encoding)
+{
+  QByteArray e(encoding.trimmed().toLower());
+
+  m_encoding = Identity;
+  m_error = false;
+  m_finished = false;
+  m_initialized = false;
+  m_raw = false;
+#ifdef PANDAMONIUM_BROTLI
+  m_brotli = 0;
+#endif
+  memset(&m_stream, 0, sizeof(m_stream));
+
+  if(e == "deflate")
+    m_encoding = Deflate;
+  else if(e == "gzip" || e == "x-gzip")
+    m_encoding = Gzip;
+#ifdef PANDAMONIUM_BROTLI
+  else if(e == "br")
+    {
+      m_brotli = BrotliDecoderCreateInstance(0, 0, 0);
+      m_encoding = Brotli;
+      m_error = m_brotli == 0;
+    }
+#endif
+  else if(!e.isEmpty() && e != "identity")
+    m_error = true; // Unsupported or stacked encodings.
+}
+
+pandamonium_kernel_decoder::~pandamonium_kernel_decoder()
+{
+#ifdef PANDAMONIUM_BROTLI
+  if(m_brotli)
+    BrotliDecoderDestroyInstance(m_brotli);
+#endif
+
+  if(m_initialized)
+    inflateEnd(&m_stream);
+}
+
+QByteArray pandamonium_kernel_decoder::acceptedEncodings(void)
+{
+#ifdef PANDAMONIUM_BROTLI
+  return "br, gzip, deflate";
+#else
+  return "gzip, deflate";
+#endif
+}
+
+QByteArray pandamonium_kernel_decoder::decode(const QByteArray &bytes)
+{
+  if(bytes.isEmpty() || m_error || m_finished)
+    return QByteArray();
+
+  switch(m_encoding)
+    {
+    case Brotli:
+      return decodeBrotli(bytes);
+    case Deflate:
+    case Gzip:
+      return decodeZlib(bytes);
+    default:
+      return bytes;
+    }
+}
+
+QByteArray pandamonium_kernel_decoder::decodeBrotli(const QByteArray &bytes)
+{
+  QByteArray decoded;
+
+#ifdef PANDAMONIUM_BROTLI
+  const uint8_t *next_in = reinterpret_cast<const uint8_t *>
+    (bytes.constData());
+  size_t available_in = static_cast<size_t> (bytes.size());
+
+  while(true)
+    {
+      BrotliDecoderResult result;
+      uint8_t buffer[s_bufferSize];
+      uint8_t *next_out = buffer;
+      size_t available_out = sizeof(buffer);
+
+      result = BrotliDecoderDecompressStream
+	(m_brotli, &available_in, &next_in, &available_out, &next_out, 0);
+      decoded.append(reinterpret_cast<const char *> (buffer),
+		     static_cast<int> (sizeof(buffer) - available_out));
+
+      if(result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT)
+	continue;
+      else if(result == BROTLI_DECODER_RESULT_ERROR)
+	m_error = true;
+      else if(result == BROTLI_DECODER_RESULT_SUCCESS)
+	m_finished = true;
+
+      break;
+    }
+#else
+  Q_UNUSED(bytes);
+  m_error = true;
+#endif
+
+  return decoded;
+}
+
+QByteArray pandamonium_kernel_decoder::decodeZlib(const QByteArray &bytes)
+{
+  QByteArray decoded;
+
+  if(!m_initialized)
+    {
+      /*
+      ** Some servers label raw deflate streams as deflate. The
+      ** first byte of a zlib stream names the deflate method.
+      */
+
+      m_raw = m_encoding == Deflate &&
+	(static_cast<unsigned char> (bytes.at(0)) & 0x0f) != 8;
+
+      if(!initializeZlib())
+	return decoded;
+    }
+
+  m_stream.avail_in = static_cast<uInt> (bytes.size());
+  m_stream.next_in = reinterpret_cast<Bytef *>
+    (const_cast<char *> (bytes.constData()));
+
+  do
+    {
+      char buffer[s_bufferSize];
+      int rc = 0;
+
+      m_stream.avail_out = sizeof(buffer);
+      m_stream.next_out = reinterpret_cast<Bytef *> (buffer);
+      rc = inflate(&m_stream, Z_NO_FLUSH);
+
+      if(rc != Z_OK && rc != Z_BUF_ERROR && rc != Z_STREAM_END)
+	{
+	  m_error = true;
+	  break;
+	}
+
+      decoded.append
+	(buffer, static_cast<int> (sizeof(buffer) - m_stream.avail_out));
+
+      if(rc == Z_STREAM_END)
+	{
+	  m_finished = true; // Trailing bytes are discarded.
+	  break;
+	}
+    }
+  while(m_stream.avail_out == 0);
+
+  m_stream.avail_in = 0;
+  m_stream.next_in = 0;
+  return decoded;
+}
+
+bool pandamonium_kernel_decoder::hasError(void) const
+{
+  return m_error;
+}
+
+bool pandamonium_kernel_decoder::initializeZlib(void)
+{
+  /*
+  ** 15 + 16 expects a gzip header. 15 + 32 detects a gzip or a zlib
+  ** header. -15 expects neither.
+  */
+
+  int windowBits = 15 + 32;
+
+  if(m_encoding == Gzip)
+    windowBits = 15 + 16;
+  else if(m_raw)
+    windowBits = -15;
+
+  m_initialized = inflateInit2(&m_stream, windowBits) == Z_OK;
+  m_error = !m_initialized;
+  return m_initialized;
+}
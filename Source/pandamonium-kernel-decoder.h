@@ -0,0 +1,82 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_decoder_h_
+#define _pandamonium_kernel_decoder_h_
+
+#include <QByteArray>
+
+#ifdef PANDAMONIUM_BROTLI
+#include <brotli/decode.h>
+#endif
+#ifdef PANDAMONIUM_QT_ZLIB
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+/*
+** Decodes a compressed body incrementally. Each chunk is decoded as it
+** arrives so that the parser is never required to wait for the
+** complete body. Brotli is available if the kernel is built with
+** CONFIG+=brotli.
+*/
+
+class pandamonium_kernel_decoder
+{
+ public:
+  pandamonium_kernel_decoder(const QByteArray &encoding);
+  ~pandamonium_kernel_decoder();
+  QByteArray decode(const QByteArray &bytes);
+  bool hasError(void) const;
+  static QByteArray acceptedEncodings(void);
+
+ private:
+  enum Encodings
+  {
+    Brotli = 0,
+    Deflate,
+    Gzip,
+    Identity
+  };
+
+  Q_DISABLE_COPY(pandamonium_kernel_decoder)
+  Encodings m_encoding;
+  bool m_error;
+  bool m_finished;
+  bool m_initialized;
+  bool m_raw;
+#ifdef PANDAMONIUM_BROTLI
+  BrotliDecoderState *m_brotli;
+#endif
+  z_stream m_stream;
+  QByteArray decodeBrotli(const QByteArray &bytes);
+  QByteArray decodeZlib(const QByteArray &bytes);
+  bool initializeZlib(void);
+};
+
+#endif
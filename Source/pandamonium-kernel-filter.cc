@@ -0,0 +1,288 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDataStream>
+#include <QFile>
+#include <QSettings>
+#include <QtDebug>
+
+#include <math.h>
+
+#include "pandamonium-common.h"
+#include "pandamonium-database.h"
+#include "pandamonium-kernel-filter.h"
+#include "pandamonium-kernel-urlstore.h"
+
+pandamonium_kernel_filter::pandamonium_kernel_filter(void)
+{
+  m_capacity = 0;
+  m_hashes = 1;
+  m_ones = 0;
+  m_rate = qBound
+    (0.000001,
+     QSettings().value("pandamonium_filter_false_positive_rate", 0.001).
+     toDouble(),
+     0.1);
+  m_size = 0;
+}
+
+pandamonium_kernel_filter::~pandamonium_kernel_filter()
+{
+}
+
+QString pandamonium_kernel_filter::fileName(void)
+{
+  return pandamonium_common::homePath() + QDir::separator() +
+    "pandamonium_visited_urls.filter";
+}
+
+bool pandamonium_kernel_filter::contains(const quint64 hash) const
+{
+  if(m_bits.isEmpty())
+    return false;
+
+  /*
+  ** Double hashing (Kirsch and Mitzenmacher).
+  */
+
+  quint64 bits = static_cast<quint64> (m_bits.size()) * 64;
+  quint64 h1 = hash & 0xffffffff;
+  quint64 h2 = (hash >> 32) | 1;
+
+  for(int i = 0; i < m_hashes; i++)
+    {
+      quint64 bit = (h1 + static_cast<quint64> (i) * h2) % bits;
+
+      if(!(m_bits.at(static_cast<int> (bit / 64)) &
+	   (Q_UINT64_C(1) << (bit % 64))))
+	return false;
+    }
+
+  return true;
+}
+
+bool pandamonium_kernel_filter::insert(const quint64 hash)
+{
+  if(m_bits.isEmpty())
+    return true;
+
+  bool inserted = false;
+  quint64 bits = static_cast<quint64> (m_bits.size()) * 64;
+  quint64 h1 = hash & 0xffffffff;
+  quint64 h2 = (hash >> 32) | 1;
+
+  for(int i = 0; i < m_hashes; i++)
+    {
+      quint64 bit = (h1 + static_cast<quint64> (i) * h2) % bits;
+      quint64 &word(m_bits[static_cast<int> (bit / 64)]);
+
+      if(!(word & (Q_UINT64_C(1) << (bit % 64))))
+	{
+	  inserted = true;
+	  m_ones += 1;
+	  word |= Q_UINT64_C(1) << (bit % 64);
+	}
+    }
+
+  if(inserted)
+    m_size += 1;
+
+  return inserted;
+}
+
+bool pandamonium_kernel_filter::isSaturated(void) const
+{
+  return m_size > m_capacity;
+}
+
+bool pandamonium_kernel_filter::load(void)
+{
+  QFile file(fileName());
+
+  if(!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QDataStream stream(&file);
+  QPair<quint64, qint64> extent;
+  QVector<quint64> bits;
+  double rate = 0.0;
+  qint32 hashes = 0;
+  quint32 magic = 0;
+  quint64 capacity = 0;
+  quint64 ones = 0;
+  quint64 size = 0;
+
+  stream >> magic;
+
+  if(magic != s_magic)
+    return false;
+
+  stream >> extent.first
+	 >> extent.second
+	 >> rate
+	 >> capacity
+	 >> hashes
+	 >> ones
+	 >> size
+	 >> bits;
+
+  /*
+  ** The filter is current if pandamonium_visited_urls has not changed
+  ** since it was saved.
+  */
+
+  if(stream.status() != QDataStream::Ok ||
+     bits.isEmpty() ||
+     extent != m_extent ||
+     hashes < 1 ||
+     qAbs(rate - m_rate) > 0.0000001)
+    return false;
+
+  /*
+  ** A filter which survived a crash would be stale.
+  */
+
+  file.close();
+  file.remove();
+  m_bits = bits;
+  m_capacity = capacity;
+  m_hashes = hashes;
+  m_ones = ones;
+  m_size = size;
+  return true;
+}
+
+double pandamonium_kernel_filter::falsePositiveRate(void) const
+{
+  if(m_bits.isEmpty())
+    return 0.0;
+
+  return pow(static_cast<double> (m_ones) /
+	     (64.0 * static_cast<double> (m_bits.size())),
+	     m_hashes);
+}
+
+quint64 pandamonium_kernel_filter::capacity(void) const
+{
+  return m_capacity;
+}
+
+quint64 pandamonium_kernel_filter::size(void) const
+{
+  return m_size;
+}
+
+void pandamonium_kernel_filter::rebuild
+(const pandamonium_kernel_urlstore &store)
+{
+  m_extent = pandamonium_database::visitedUrlsExtent();
+  m_extent.first += store.size();
+
+  if(load())
+    return;
+
+  resize(qMax(static_cast<quint64> (s_minimumCapacity),
+	      2 * m_extent.first));
+
+  QPair<QList<qint64>, qint64> list;
+
+  list.second = 0;
+
+  do
+    {
+      list = pandamonium_database::visitedUrlHashes(list.second, 16384);
+
+      for(int i = 0; i < list.first.size(); i++)
+	insert(static_cast<quint64> (list.first.at(i)));
+    }
+  while(!list.first.isEmpty());
+
+  QByteArray url;
+  int depth = 0;
+  pandamonium_kernel_urlstore_cursor cursor;
+
+  while(store.next(cursor, url, depth))
+    insert(pandamonium_common::hash(url));
+}
+
+void pandamonium_kernel_filter::resize(const quint64 capacity)
+{
+  /*
+  ** m = -n ln(p) / ln(2)^2 bits and k = (m / n) ln(2) hashes.
+  */
+
+  double bits = -static_cast<double> (capacity) * log(m_rate) /
+    (log(2.0) * log(2.0));
+
+  m_bits.fill
+    (0, qBound(1, static_cast<int> (ceil(bits / 64.0)), 0x7fffffff / 64));
+  m_capacity = capacity;
+  m_hashes = qBound
+    (1,
+     static_cast<int> (ceil(64.0 * static_cast<double> (m_bits.size()) /
+			    static_cast<double> (capacity) * log(2.0))),
+     32);
+  m_ones = 0;
+  m_size = 0;
+}
+
+void pandamonium_kernel_filter::save(const pandamonium_kernel_urlstore &store)
+{
+  QFile::remove(fileName());
+
+  if(m_bits.isEmpty() ||
+     !QSettings().value("pandamonium_filter_persist", true).toBool())
+    return;
+
+  QFile file(fileName());
+
+  if(!file.open(QIODevice::Truncate | QIODevice::WriteOnly))
+    {
+      qDebug() << "Cannot open " << file.fileName() << "!";
+      return;
+    }
+
+  QDataStream stream(&file);
+
+  m_extent = pandamonium_database::visitedUrlsExtent();
+  m_extent.first += store.size();
+  stream << s_magic
+	 << m_extent.first
+	 << m_extent.second
+	 << m_rate
+	 << m_capacity
+	 << static_cast<qint32> (m_hashes)
+	 << m_ones
+	 << m_size
+	 << m_bits;
+
+  if(stream.status() != QDataStream::Ok)
+    {
+      file.close();
+      file.remove();
+    }
+}
@@ -0,0 +1,75 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_filter_h_
+#define _pandamonium_kernel_filter_h_
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class pandamonium_kernel_urlstore;
+
+/*
+** A Bloom filter of the URLs of pandamonium_visited_urls and of the
+** URL store. A URL which the filter does not contain is new. A URL
+** which it contains is known, except with the probability
+** falsePositiveRate(). The filter is sized for twice the number of
+** rows at startup and is saved to pandamonium_visited_urls.filter when
+** the kernel exits.
+*/
+
+class pandamonium_kernel_filter
+{
+ public:
+  pandamonium_kernel_filter(void);
+  ~pandamonium_kernel_filter();
+  bool contains(const quint64 hash) const;
+  bool insert(const quint64 hash);
+  bool isSaturated(void) const;
+  double falsePositiveRate(void) const;
+  quint64 capacity(void) const;
+  quint64 size(void) const;
+  void rebuild(const pandamonium_kernel_urlstore &store);
+  void save(const pandamonium_kernel_urlstore &store);
+
+ private:
+  QPair<quint64, qint64> m_extent; // Rows, maximum rowid.
+  QVector<quint64> m_bits;
+  double m_rate;
+  int m_hashes;
+  quint64 m_capacity;
+  quint64 m_ones;
+  quint64 m_size;
+  static const quint32 s_magic = 0x50424631; // PBF1.
+  static const quint64 s_minimumCapacity = 1048576;
+  static QString fileName(void);
+  bool load(void);
+  void resize(const quint64 capacity);
+};
+
+#endif
@@ -0,0 +1,295 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QtDebug>
+
+#include "pandamonium-common.h"
+#include "pandamonium-database.h"
+#include "pandamonium-kernel-frontier.h"
+
+pandamonium_kernel_frontier::pandamonium_kernel_frontier(void)
+{
+  m_depth = 0;
+  m_nextDatabaseRefill = 0;
+  m_size = 0;
+  m_spillOffset = 0;
+  m_spill.setFileName(pandamonium_common::homePath() + QDir::separator() +
+		      "pandamonium_frontier.spill");
+
+  /*
+  ** A previous segment is discarded. Its URLs are recovered from
+  ** pandamonium_visited_urls.
+  */
+
+  if(!m_spill.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    qDebug() << "Cannot open " << m_spill.fileName() << "!";
+}
+
+pandamonium_kernel_frontier::~pandamonium_kernel_frontier()
+{
+  m_spill.close();
+  m_spill.remove();
+}
+
+bool pandamonium_kernel_frontier::isEmpty(void) const
+{
+  return m_size == 0;
+}
+
+int pandamonium_kernel_frontier::depth(void) const
+{
+  return m_depth;
+}
+
+int pandamonium_kernel_frontier::size(void) const
+{
+  return m_size;
+}
+
+pandamonium_frontier_entry pandamonium_kernel_frontier::pop(void)
+{
+  /*
+  ** The shallowest URL first.
+  */
+
+  QMap<int, QQueue<pandamonium_frontier_entry> >::iterator
+    it(m_hot.begin());
+
+  while(it != m_hot.end())
+    if(it.value().isEmpty())
+      it = m_hot.erase(it);
+    else
+      {
+	pandamonium_frontier_entry entry(it.value().dequeue());
+
+	if(it.value().isEmpty())
+	  m_hot.erase(it);
+
+	m_size -= 1;
+	return entry;
+      }
+
+  return pandamonium_frontier_entry();
+}
+
+qint64 pandamonium_kernel_frontier::spilled(void) const
+{
+  return m_spill.isOpen() ? m_spill.size() - m_spillOffset : 0;
+}
+
+void pandamonium_kernel_frontier::defer
+(const QUrl &url, const int depth, const qint64 seed)
+{
+  if(url.isEmpty() || !url.isValid())
+    return;
+
+  if(!m_spill.isOpen())
+    {
+      m_hot[qMax(0, depth)].enqueue
+	(pandamonium_frontier_entry(url, qMax(0, depth), seed));
+      m_size += 1;
+      return;
+    }
+
+  /*
+  ** depth seed url
+  */
+
+  m_spill.seek(m_spill.size());
+  m_spill.write(QByteArray::number(qMax(0, depth)));
+  m_spill.write(" ");
+  m_spill.write(QByteArray::number(seed));
+  m_spill.write(" ");
+  m_spill.write(pandamonium_common::toEncoded(url));
+  m_spill.write("\n");
+}
+
+void pandamonium_kernel_frontier::push
+(const QUrl &url, const int depth, const qint64 seed)
+{
+  if(url.isEmpty() || !url.isValid())
+    return;
+
+  if(m_size < s_capacity && spilled() == 0)
+    {
+      m_hot[qMax(0, depth)].enqueue
+	(pandamonium_frontier_entry(url, qMax(0, depth), seed));
+      m_size += 1;
+    }
+  else
+    defer(url, depth, seed);
+}
+
+void pandamonium_kernel_frontier::readSpill(void)
+{
+  if(!m_spill.isOpen())
+    return;
+
+  m_spill.seek(m_spillOffset);
+
+  while(m_size < s_capacity && !m_spill.atEnd())
+    {
+      QList<QByteArray> list(m_spill.readLine().trimmed().split(' '));
+
+      if(list.size() == 3)
+	{
+	  QUrl url(QUrl::fromEncoded(list.at(2)));
+
+	  if(!url.isEmpty() && url.isValid())
+	    {
+	      int depth = qMax(0, list.at(0).toInt());
+	      qint64 seed = list.at(1).toLongLong();
+
+	      m_hot[depth].enqueue
+		(pandamonium_frontier_entry(url, depth, seed));
+	      m_size += 1;
+	    }
+	}
+    }
+
+  m_spillOffset = m_spill.pos();
+
+  if(m_spillOffset >= m_spill.size())
+    {
+      /*
+      ** The segment has been consumed.
+      */
+
+      m_spill.resize(0);
+      m_spillOffset = 0;
+    }
+  else if(m_spillOffset >= s_spillCompactionThreshold &&
+	  m_spillOffset >= m_spill.size() / 2)
+    compactSpill();
+}
+
+void pandamonium_kernel_frontier::compactSpill(void)
+{
+  /*
+  ** The consumed prefix of the segment is discarded by moving the
+  ** unread lines to the beginning of the file. The unread lines are not
+  ** longer than the prefix, so they are not overwritten while they are
+  ** copied.
+  */
+
+  qint64 readOffset = m_spillOffset;
+  qint64 size = m_spill.size();
+  qint64 writeOffset = 0;
+
+  while(readOffset < size)
+    {
+      m_spill.seek(readOffset);
+
+      QByteArray bytes(m_spill.read(qMin(static_cast<qint64> (65536),
+					 size - readOffset)));
+
+      if(bytes.isEmpty())
+	return;
+
+      readOffset += bytes.size();
+      m_spill.seek(writeOffset);
+
+      if(m_spill.write(bytes) != bytes.size())
+	{
+	  qDebug() << "Cannot compact " << m_spill.fileName() << "!";
+	  return;
+	}
+
+      writeOffset += bytes.size();
+    }
+
+  m_spill.resize(writeOffset);
+  m_spillOffset = 0;
+}
+
+void pandamonium_kernel_frontier::refill(const qint64 now)
+{
+  if(m_size >= s_capacity / 4)
+    return;
+
+  if(spilled() > 0)
+    readSpill();
+
+  if(m_size >= s_capacity / 4)
+    return;
+  else if(now < m_nextDatabaseRefill)
+    return;
+
+  QPair<QList<QPair<QUrl, qint64> >, qint64> pair
+    (pandamonium_database::unvisitedChildUrls(m_depth,
+					      m_lastRowIds.value(m_depth, 0),
+					      s_batchSize));
+
+  m_lastRowIds[m_depth] = pair.second;
+
+  if(pair.first.isEmpty())
+    {
+      /*
+      ** The current depth has been exhausted. Proceed to the next
+      ** populated depth. Otherwise, return to the shallowest depth
+      ** after a short delay. Rows which were inserted after their
+      ** depth's cursor will then be discovered.
+      */
+
+      int depth = pandamonium_database::minimumUnvisitedDepth(m_depth);
+
+      if(depth > m_depth)
+	m_depth = depth;
+      else
+	{
+	  m_depth = 0;
+	  m_nextDatabaseRefill = now + 1000;
+	}
+
+      return;
+    }
+
+  while(!pair.first.isEmpty())
+    {
+      QPair<QUrl, qint64> url(pair.first.takeFirst()); // URL, seed.
+
+      push(url.first, m_depth, url.second);
+    }
+}
+
+void pandamonium_kernel_frontier::reset(void)
+{
+  /*
+  ** pandamonium_visited_urls has been replaced. Its URLs are read again
+  ** from the shallowest depth.
+  */
+
+  m_depth = 0;
+  m_hot.clear();
+  m_lastRowIds.clear();
+  m_nextDatabaseRefill = 0;
+  m_size = 0;
+  m_spillOffset = 0;
+
+  if(m_spill.isOpen())
+    m_spill.resize(0);
+}
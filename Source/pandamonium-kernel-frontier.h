@@ -0,0 +1,101 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_frontier_h_
+#define _pandamonium_kernel_frontier_h_
+
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QQueue>
+#include <QUrl>
+
+class pandamonium_frontier_entry
+{
+ public:
+  pandamonium_frontier_entry(void)
+  {
+    m_depth = 0;
+    m_seed = 0;
+  }
+
+  pandamonium_frontier_entry(const QUrl &url,
+			     const int depth,
+			     const qint64 seed)
+  {
+    m_depth = depth;
+    m_seed = seed;
+    m_url = url;
+  }
+
+  QUrl m_url;
+  int m_depth;
+  qint64 m_seed; // The search URL which discovered the URL, or zero.
+};
+
+/*
+** The crawl frontier. Unvisited URLs are served from bounded in-memory
+** queues, one per depth, so that the crawl proceeds breadth-first.
+** The queues are refilled in bulk, first from the spill segment and then
+** from pandamonium_visited_urls in ascending rowid order, one depth at a
+** time. URLs which do not fit in memory are appended to the spill segment.
+** Each URL is accompanied by its search URL so that the search URL's
+** limits apply to it.
+** The segment's consumed prefix is discarded once it is large.
+*/
+
+class pandamonium_kernel_frontier
+{
+ public:
+  pandamonium_kernel_frontier(void);
+  ~pandamonium_kernel_frontier();
+  bool isEmpty(void) const;
+  int depth(void) const;
+  int size(void) const;
+  pandamonium_frontier_entry pop(void);
+  qint64 spilled(void) const;
+  void defer(const QUrl &url, const int depth, const qint64 seed);
+  void push(const QUrl &url, const int depth, const qint64 seed);
+  void refill(const qint64 now);
+  void reset(void);
+
+ private:
+  QFile m_spill;
+  QHash<int, qint64> m_lastRowIds;
+  QMap<int, QQueue<pandamonium_frontier_entry> > m_hot;
+  int m_depth;
+  int m_size;
+  qint64 m_nextDatabaseRefill;
+  qint64 m_spillOffset;
+  static const int s_batchSize = 1024;
+  static const int s_capacity = 4096;
+  static const qint64 s_spillCompactionThreshold = 1048576;
+  void compactSpill(void);
+  void readSpill(void);
+};
+
+#endif
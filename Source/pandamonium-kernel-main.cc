@@ -25,17 +25,167 @@
 ** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <QApplication>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
 #include <QSettings>
+#ifdef PANDAMONIUM_BENCHMARK_QTEXTDOCUMENT
+#if QT_VERSION >= 0x050000
+#include <QGuiApplication>
+#else
+#include <QApplication>
+#endif
+#include <QRegExp>
+#include <QTextDocument>
+#endif
 
 #include <iostream>
 
 #include "pandamonium-common.h"
 #include "pandamonium-database.h"
 #include "pandamonium-kernel.h"
+#include "pandamonium-kernel-parser.h"
+#include "pandamonium-kernel-scanner.h"
 
 static qint64 s_kernel_process_id = 0;
 
+#ifdef PANDAMONIUM_BENCHMARK_QTEXTDOCUMENT
+static void benchmark_qtextdocument(const QList<QByteArray> &corpus,
+				    const qint64 bytes)
+{
+  /*
+  ** The words of a page as they were gathered before the parser
+  ** extracted text.
+  */
+
+  QElapsedTimer timer;
+  qint64 rounds = 0;
+  qint64 words = 0;
+
+  timer.start();
+
+  do
+    {
+      foreach(const QByteArray &content, corpus)
+	{
+	  QTextDocument textDocument;
+
+	  textDocument.setHtml(QString::fromUtf8(content));
+	  words += textDocument.toPlainText().
+#if QT_VERSION >= 0x050e00
+	    split(QRegExp("\\W+"), Qt::SkipEmptyParts).size();
+#else
+	    split(QRegExp("\\W+"), QString::SkipEmptyParts).size();
+#endif
+	}
+
+      rounds += 1;
+    }
+  while(timer.elapsed() < 2500);
+
+  double seconds = static_cast<double> (timer.nsecsElapsed()) / 1e9;
+
+  std::cout << "QTextDocument (text): "
+	    << static_cast<double> (bytes * rounds) / seconds / 1048576.0
+	    << " MiB/s, "
+	    << words / rounds
+	    << " words per round."
+	    << std::endl;
+}
+#endif
+
+static int benchmark_parser(const QString &path)
+{
+  /*
+  ** Parse every file below path with each of the supported scanners.
+  */
+
+  QDirIterator it
+    (path, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+  QList<QByteArray> corpus;
+  qint64 bytes = 0;
+
+  while(it.hasNext())
+    {
+      QFile file(it.next());
+
+      if(file.open(QIODevice::ReadOnly))
+	{
+	  corpus << file.readAll();
+	  bytes += corpus.last().size();
+	}
+    }
+
+  if(bytes == 0)
+    {
+      std::cerr << "The directory " << path.toStdString()
+		<< " does not contain readable files." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  std::cout << corpus.size() << " files, " << bytes << " bytes."
+	    << std::endl;
+
+  QList<pandamonium_kernel_scanner::Implementations> list;
+
+  list << pandamonium_kernel_scanner::Scalar
+       << pandamonium_kernel_scanner::SSE2
+       << pandamonium_kernel_scanner::AVX2;
+
+  foreach(pandamonium_kernel_scanner::Implementations implementation, list)
+    {
+      if(!pandamonium_kernel_scanner::setImplementation(implementation))
+	continue;
+
+      for(int i = 0; i < 2; i++)
+	{
+	  QElapsedTimer timer;
+	  pandamonium_kernel_parser parser;
+	  qint64 characters = 0;
+	  qint64 links = 0;
+	  qint64 rounds = 0;
+
+	  parser.setExtractText(i == 1);
+	  timer.start();
+
+	  do
+	    {
+	      foreach(const QByteArray &content, corpus)
+		{
+		  parser.parse(content);
+		  characters += parser.text().length();
+		  links += parser.links().size();
+		}
+
+	      rounds += 1;
+	    }
+	  while(timer.elapsed() < 2500);
+
+	  double seconds = static_cast<double> (timer.nsecsElapsed()) / 1e9;
+
+	  std::cout << pandamonium_kernel_scanner::implementationName().
+	    toStdString()
+		    << (i == 1 ? " (text)" : "")
+		    << ": "
+		    << static_cast<double> (bytes * rounds) / seconds /
+	    1048576.0
+		    << " MiB/s, "
+		    << links / rounds
+		    << " links and "
+		    << characters / rounds
+		    << " characters per round."
+		    << std::endl;
+	}
+    }
+
+  pandamonium_kernel_scanner::setImplementation
+    (pandamonium_kernel_scanner::Automatic);
+#ifdef PANDAMONIUM_BENCHMARK_QTEXTDOCUMENT
+  benchmark_qtextdocument(corpus, bytes);
+#endif
+  return EXIT_SUCCESS;
+}
+
 static void signal_handler(int signal_number)
 {
   static int fatal_error = 0;
@@ -53,16 +203,22 @@ int main(int argc, char *argv[])
   pandamonium_common::prepareSignalHandler(signal_handler);
   qputenv("TZ", ":UTC");
 
+#ifdef PANDAMONIUM_BENCHMARK_QTEXTDOCUMENT
+  /*
+  ** QTextDocument requires fonts. Try -platform offscreen.
+  */
+
+#if QT_VERSION >= 0x050000
+  QGuiApplication qapplication(argc, argv);
+#else
   QApplication qapplication(argc, argv);
+#endif
+#else
+  QCoreApplication qapplication(argc, argv);
+#endif
 
   s_kernel_process_id = qapplication.applicationPid();
 
-  if(pandamonium_database::isKernelActive())
-    {
-      qapplication.exit(EXIT_FAILURE);
-      return EXIT_FAILURE;
-    }
-
 #ifdef Q_OS_MAC
 #if QT_VERSION >= 0x050000
   /*
@@ -72,14 +228,35 @@ int main(int argc, char *argv[])
   CocoaInitializer ci;
 #endif
 #endif
-  QApplication::setApplicationName("pandamonium");
-  QApplication::setOrganizationName("pandamonium");
-  QApplication::setOrganizationDomain("pandamonium");
-  QApplication::setApplicationVersion(pandamonium_VERSION_STR);
+  QCoreApplication::setApplicationName("pandamonium");
+  QCoreApplication::setOrganizationName("pandamonium");
+  QCoreApplication::setOrganizationDomain("pandamonium");
+  QCoreApplication::setApplicationVersion(pandamonium_VERSION_STR);
   QSettings::setPath(QSettings::IniFormat, QSettings::UserScope,
                      pandamonium_common::homePath());
   QSettings::setDefaultFormat(QSettings::IniFormat);
 
+  {
+    QStringList arguments(qapplication.arguments());
+    int index = arguments.indexOf("--benchmark-parser");
+
+    if(index >= 0)
+      return benchmark_parser(arguments.value(index + 1, "."));
+  }
+
+  /*
+  ** The settings must be available before the first database
+  ** connection is established.
+  */
+
+  pandamonium_database::disableAutomaticCheckpoints();
+
+  if(pandamonium_database::isKernelActive())
+    {
+      qapplication.exit(EXIT_FAILURE);
+      return EXIT_FAILURE;
+    }
+
   pandamonium_kernel *p = 0;
 
   try
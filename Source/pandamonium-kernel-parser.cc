@@ -0,0 +1,791 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "pandamonium-kernel-parser.h"
+#include "pandamonium-kernel-scanner.h"
+
+static inline bool isLetter(const char c)
+{
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+static inline bool isSpace(const char c)
+{
+  return c == ' ' || c == '\f' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline char toLower(const char c)
+{
+  if(c >= 'A' && c <= 'Z')
+    return static_cast<char> (c + 32);
+  else
+    return c;
+}
+
+static const struct
+{
+  const char *m_name;
+  uint m_codePoint;
+} s_references[] = {{"amp", 0x26},
+		    {"apos", 0x27},
+		    {"bull", 0x2022},
+		    {"copy", 0xa9},
+		    {"euro", 0x20ac},
+		    {"gt", 0x3e},
+		    {"hellip", 0x2026},
+		    {"laquo", 0xab},
+		    {"ldquo", 0x201c},
+		    {"lsquo", 0x2018},
+		    {"lt", 0x3c},
+		    {"mdash", 0x2014},
+		    {"middot", 0xb7},
+		    {"nbsp", 0x20},
+		    {"ndash", 0x2013},
+		    {"quot", 0x22},
+		    {"raquo", 0xbb},
+		    {"rdquo", 0x201d},
+		    {"reg", 0xae},
+		    {"rsquo", 0x2019},
+		    {"trade", 0x2122},
+		    {0, 0}};
+
+pandamonium_kernel_parser::pandamonium_kernel_parser(void)
+{
+  m_extractText = false;
+  m_final = false;
+  m_headComplete = false;
+  m_rawText = Other;
+  m_skipTag = false;
+  m_titleFound = false;
+}
+
+QByteArray pandamonium_kernel_parser::title(void) const
+{
+  return m_title;
+}
+
+QList<QByteArray> pandamonium_kernel_parser::links(void) const
+{
+  return m_links;
+}
+
+QList<QByteArray> pandamonium_kernel_parser::metaData(void) const
+{
+  return m_metaData;
+}
+
+QString pandamonium_kernel_parser::text(void) const
+{
+  return m_text;
+}
+
+bool pandamonium_kernel_parser::isHeadComplete(void) const
+{
+  return m_headComplete;
+}
+
+bool pandamonium_kernel_parser::equals
+(const char *a, const int length, const char *lowercase)
+{
+  int i = 0;
+
+  for(; i < length; i++)
+    if(lowercase[i] == 0 || toLower(a[i]) != lowercase[i])
+      return false;
+
+  return lowercase[i] == 0;
+}
+
+const char *pandamonium_kernel_parser::appendReference
+(const char *p, const char *end)
+{
+  /*
+  ** p references a '&'. Unknown references are preserved.
+  */
+
+  const char *e = p + 1;
+
+  while(e < end && e - p <= 10 && *e != ';')
+    e += 1;
+
+  if(e >= end || *e != ';' || e - p < 3)
+    {
+      appendCodePoint('&');
+      return p + 1;
+    }
+
+  const char *name = p + 1;
+  int length = static_cast<int> (e - name);
+  uint c = 0;
+
+  if(*name == '#')
+    {
+      bool ok = false;
+
+      if(toLower(name[1]) == 'x')
+	c = QByteArray(name + 2, length - 2).toUInt(&ok, 16);
+      else
+	c = QByteArray(name + 1, length - 1).toUInt(&ok, 10);
+
+      if(!ok)
+	c = 0;
+    }
+  else
+    for(int i = 0; s_references[i].m_name; i++)
+      if(qstrncmp(name, s_references[i].m_name, length) == 0 &&
+	 s_references[i].m_name[length] == 0)
+	{
+	  c = s_references[i].m_codePoint;
+	  break;
+	}
+
+  if(c == 0)
+    {
+      appendCodePoint('&');
+      return p + 1;
+    }
+
+  appendCodePoint(c);
+  return e + 1;
+}
+
+const char *pandamonium_kernel_parser::endTag
+(const char *p, const char *end, const char *lowercase)
+{
+  /*
+  ** Locate </lowercase. The returned pointer references the '<'.
+  */
+
+  int length = static_cast<int> (qstrlen(lowercase));
+
+  while(p < end)
+    {
+      p = pandamonium_kernel_scanner::find(p, end, '<');
+
+      if(p == end)
+	return end;
+
+      if(end - p >= length + 2 && p[1] == '/' && equals(p + 2, length,
+							   lowercase))
+	return p;
+
+      p += 1;
+    }
+
+  return end;
+}
+
+const char *pandamonium_kernel_parser::parseTag
+(const char *p, const char *end)
+{
+  /*
+  ** p references a '<'. The returned pointer references the first
+  ** byte which follows the tag. Zero is returned if the tag is
+  ** incomplete and more content is expected.
+  */
+
+  const char *incomplete = m_final ? end : 0;
+  const char *q = p + 1;
+
+  if(q >= end)
+    return incomplete;
+
+  if(*q == '!' || *q == '?')
+    {
+      if(end - q < 3 && !m_final)
+	return incomplete;
+
+      if(end - q >= 3 && q[1] == '-' && q[2] == '-')
+	{
+	  /*
+	  ** A comment.
+	  */
+
+	  for(q += 3; (q = pandamonium_kernel_scanner::
+		       find(q, end, '>')) < end; q++)
+	    if(q[-1] == '-' && q[-2] == '-')
+	      return q + 1;
+
+	  return incomplete;
+	}
+
+      q = pandamonium_kernel_scanner::find(q, end, '>');
+      return q < end ? q + 1 : incomplete;
+    }
+
+  bool closing = false;
+
+  if(*q == '/')
+    {
+      closing = true;
+      q += 1;
+    }
+
+  if(q >= end)
+    return incomplete;
+  else if(!isLetter(*q))
+    {
+      if(m_extractText)
+	appendCodePoint('<');
+
+      return p + 1; // Not a tag.
+    }
+
+  const char *name = q;
+
+  while(q < end && !isSpace(*q) && *q != '/' && *q != '>')
+    q += 1;
+
+  if(q >= end && !m_final)
+    return incomplete;
+
+  QByteArray content;
+  QByteArray href;
+  Tags t = tag(name, static_cast<int> (q - name));
+  bool complete = false;
+  bool metaData = false;
+
+  if(closing && equals(name, static_cast<int> (q - name), "head"))
+    m_headComplete = true;
+  else if(!closing && equals(name, static_cast<int> (q - name), "body"))
+    m_headComplete = true;
+
+  if(m_extractText && t != A && t != Inline)
+    appendSpace(); // Words do not span blocks.
+
+  if(closing || t == Inline || t == Other)
+    {
+      /*
+      ** The attributes are not of interest. Skip to the end of the tag,
+      ** respecting quoted values.
+      */
+
+      while((q = pandamonium_kernel_scanner::find(q, end, '>', '"', '\'')) <
+	    end)
+	if(*q == '>')
+	  return q + 1;
+	else if((q = pandamonium_kernel_scanner::find(q + 1, end, *q)) < end)
+	  q += 1;
+
+      return incomplete;
+    }
+
+  while(q < end)
+    {
+      while(q < end && (isSpace(*q) || *q == '/'))
+	q += 1;
+
+      if(q >= end)
+	break;
+      else if(*q == '>')
+	{
+	  complete = true;
+	  q += 1;
+	  break;
+	}
+
+      const char *attribute = q;
+
+      while(q < end && !isSpace(*q) && *q != '/' && *q != '=' && *q != '>')
+	q += 1;
+
+      int attributeLength = static_cast<int> (q - attribute);
+
+      while(q < end && isSpace(*q))
+	q += 1;
+
+      if(q >= end || *q != '=')
+	{
+	  if(attributeLength == 0)
+	    q += 1; // Stray.
+
+	  continue;
+	}
+
+      q += 1;
+
+      while(q < end && isSpace(*q))
+	q += 1;
+
+      const char *value = q;
+      int valueLength = 0;
+
+      if(q < end && (*q == '"' || *q == '\''))
+	{
+	  value = q + 1;
+	  q = pandamonium_kernel_scanner::find(value, end, *q);
+	  valueLength = static_cast<int> (q - value);
+
+	  if(q < end)
+	    q += 1;
+	}
+      else
+	{
+	  while(q < end && !isSpace(*q) && *q != '>')
+	    q += 1;
+
+	  valueLength = static_cast<int> (q - value);
+	}
+
+      if(t == A)
+	{
+	  if(equals(attribute, attributeLength, "href"))
+	    href = QByteArray(value, valueLength).trimmed();
+	}
+      else if(t == Meta)
+	{
+	  if(equals(attribute, attributeLength, "content"))
+	    content = QByteArray(value, valueLength);
+	  else if(equals(attribute, attributeLength, "name"))
+	    metaData = equals(value, valueLength, "description") ||
+	      equals(value, valueLength, "keywords");
+	}
+    }
+
+  if(!complete && !m_final)
+    return incomplete;
+
+  switch(t)
+    {
+    case A:
+      {
+	if(!href.isEmpty())
+	  m_links << href.replace("&amp;", "&");
+
+	break;
+      }
+    case Meta:
+      {
+	if(metaData && !content.isEmpty())
+	  m_metaData << content;
+
+	break;
+      }
+    case Script:
+    case Style:
+    case Title:
+      {
+	m_rawText = t; // The contents are consumed by process().
+	break;
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return q;
+}
+
+pandamonium_kernel_parser::Tags pandamonium_kernel_parser::tag
+(const char *name, const int length)
+{
+  switch(length)
+    {
+    case 1:
+      {
+	char c = toLower(name[0]);
+
+	if(c == 'a')
+	  return A;
+	else if(c == 'b' || c == 'i' || c == 'q' || c == 's' || c == 'u')
+	  return Inline;
+
+	break;
+      }
+    case 2:
+      {
+	if(equals(name, length, "em"))
+	  return Inline;
+
+	break;
+      }
+    case 3:
+      {
+	if(equals(name, length, "sub") || equals(name, length, "sup"))
+	  return Inline;
+
+	break;
+      }
+    case 4:
+      {
+	if(equals(name, length, "meta"))
+	  return Meta;
+	else if(equals(name, length, "abbr") ||
+		equals(name, length, "code") ||
+		equals(name, length, "font") ||
+		equals(name, length, "mark") ||
+		equals(name, length, "span"))
+	  return Inline;
+
+	break;
+      }
+    case 5:
+      {
+	if(equals(name, length, "small"))
+	  return Inline;
+	else if(equals(name, length, "style"))
+	  return Style;
+	else if(equals(name, length, "title"))
+	  return Title;
+
+	break;
+      }
+    case 6:
+      {
+	if(equals(name, length, "script"))
+	  return Script;
+	else if(equals(name, length, "strong"))
+	  return Inline;
+
+	break;
+      }
+    default:
+      {
+	break;
+      }
+    }
+
+  return Other;
+}
+
+void pandamonium_kernel_parser::appendCodePoint(const uint c)
+{
+  if(c < 0x20 || c == 0x7f || (c >= 0xd800 && c <= 0xdfff) || c > 0x10ffff)
+    {
+      if(c == '\n' || c == '\r' || c == '\t')
+	appendSpace();
+      else
+	m_text.append(QChar(0xfffd));
+    }
+  else if(c == 0x20)
+    appendSpace();
+  else if(c > 0xffff)
+    {
+      uint u = c - 0x10000;
+
+      m_text.append(QChar(static_cast<ushort> (0xd800 + (u >> 10))));
+      m_text.append(QChar(static_cast<ushort> (0xdc00 + (u & 0x3ff))));
+    }
+  else
+    m_text.append(QChar(static_cast<ushort> (c)));
+}
+
+void pandamonium_kernel_parser::appendSpace(void)
+{
+  if(!m_text.isEmpty() && m_text.at(m_text.length() - 1) != QChar(' '))
+    m_text.append(QChar(' '));
+}
+
+void pandamonium_kernel_parser::appendText(const char *p, const char *end)
+{
+  /*
+  ** Decode UTF-8 and character references. Runs of white space are
+  ** collapsed.
+  */
+
+  while(p < end)
+    {
+      uchar c = static_cast<uchar> (*p);
+
+      if(c == '&')
+	{
+	  p = appendReference(p, end);
+	  continue;
+	}
+      else if(c < 0x80)
+	{
+	  if(isSpace(static_cast<char> (c)))
+	    appendSpace();
+	  else
+	    appendCodePoint(c);
+
+	  p += 1;
+	  continue;
+	}
+
+      int length = 0;
+      uint u = 0;
+
+      if((c & 0xe0) == 0xc0)
+	{
+	  length = 2;
+	  u = c & 0x1f;
+	}
+      else if((c & 0xf0) == 0xe0)
+	{
+	  length = 3;
+	  u = c & 0x0f;
+	}
+      else if((c & 0xf8) == 0xf0)
+	{
+	  length = 4;
+	  u = c & 0x07;
+	}
+
+      if(length == 0 || end - p < length)
+	{
+	  appendCodePoint(0xfffd);
+	  p += 1;
+	  continue;
+	}
+
+      int i = 1;
+
+      for(; i < length; i++)
+	if((static_cast<uchar> (p[i]) & 0xc0) == 0x80)
+	  u = (u << 6) | (static_cast<uchar> (p[i]) & 0x3f);
+	else
+	  break;
+
+      if(i < length ||
+	 (length == 2 && u < 0x80) ||
+	 (length == 3 && u < 0x800) ||
+	 (length == 4 && u < 0x10000))
+	{
+	  appendCodePoint(0xfffd); // Malformed or overlong.
+	  p += i;
+	  continue;
+	}
+
+      appendCodePoint(u);
+      p += length;
+    }
+}
+
+void pandamonium_kernel_parser::clear(void)
+{
+  m_buffer.clear();
+  m_final = false;
+  m_headComplete = false;
+  m_links.clear();
+  m_metaData.clear();
+  m_rawText = Other;
+  m_skipTag = false;
+  m_text.clear();
+  m_title.clear();
+  m_titleBytes.clear();
+  m_titleFound = false;
+}
+
+void pandamonium_kernel_parser::feed(const QByteArray &content)
+{
+  if(content.isEmpty())
+    return;
+
+  /*
+  ** Only the unconsumed tail is retained.
+  */
+
+  if(m_buffer.isEmpty())
+    {
+      const char *p = process(content.constData(),
+			      content.constData() + content.size());
+
+      m_buffer = content.mid
+	(static_cast<int> (p - content.constData()));
+    }
+  else
+    {
+      m_buffer.append(content);
+
+      const char *p = process(m_buffer.constData(),
+			      m_buffer.constData() + m_buffer.size());
+
+      m_buffer.remove(0, static_cast<int> (p - m_buffer.constData()));
+    }
+}
+
+void pandamonium_kernel_parser::finish(void)
+{
+  m_final = true;
+  process(m_buffer.constData(), m_buffer.constData() + m_buffer.size());
+  m_buffer.clear();
+
+  if(m_rawText == Title)
+    setTitle();
+
+  m_rawText = Other;
+
+  if(m_extractText)
+    m_text = m_text.trimmed();
+}
+
+void pandamonium_kernel_parser::parse(const QByteArray &content)
+{
+  clear();
+
+  if(m_extractText)
+    m_text.reserve(content.size());
+
+  feed(content);
+  finish();
+}
+
+const char *pandamonium_kernel_parser::process
+(const char *p, const char *end)
+{
+  /*
+  ** Returns a pointer to the first byte which could not be consumed.
+  */
+
+  while(p < end)
+    {
+      if(m_skipTag)
+	{
+	  const char *e = pandamonium_kernel_scanner::find(p, end, '>');
+
+	  if(e == end)
+	    return end;
+
+	  m_skipTag = false;
+	  p = e + 1;
+	  continue;
+	}
+
+      if(m_rawText != Other)
+	{
+	  const char *name =
+	    m_rawText == Script ? "script" :
+	    m_rawText == Style ? "style" : "title";
+	  const char *e = endTag(p, end, name);
+
+	  if(e == end && !m_final)
+	    {
+	      /*
+	      ** Retain enough bytes to recognize a closing tag which
+	      ** straddles two chunks.
+	      */
+
+	      const char *keep = qMax
+		(p, end - static_cast<int> (qstrlen(name)) - 1);
+
+	      if(m_rawText == Title)
+		m_titleBytes.append(p, static_cast<int> (keep - p));
+
+	      return keep;
+	    }
+
+	  if(m_rawText == Title)
+	    {
+	      m_titleBytes.append(p, static_cast<int> (e - p));
+	      setTitle();
+	    }
+
+	  m_rawText = Other;
+	  p = e;
+	  continue;
+	}
+
+      const char *q = pandamonium_kernel_scanner::find(p, end, '<');
+
+      if(q == end && !m_final)
+	{
+	  q = textBoundary(p, end);
+
+	  if(m_extractText)
+	    appendText(p, q);
+
+	  return q;
+	}
+
+      if(m_extractText)
+	appendText(p, q);
+
+      if(q == end)
+	break;
+
+      if(!(p = parseTag(q, end)))
+	{
+	  /*
+	  ** An incomplete tag is rescanned with the next chunk. A tag
+	  ** which would be rescanned indefinitely is discarded.
+	  */
+
+	  if(end - q < s_maximumTagSize)
+	    return q;
+
+	  m_skipTag = true;
+	  p = q + 1;
+	}
+    }
+
+  return end;
+}
+
+const char *pandamonium_kernel_parser::textBoundary
+(const char *p, const char *end) const
+{
+  /*
+  ** Text which ends with an incomplete UTF-8 sequence or character
+  ** reference is retained.
+  */
+
+  if(!m_extractText)
+    return end;
+
+  const char *e = end;
+
+  for(int i = 0; i < 3 && e > p; i++)
+    if((static_cast<uchar> (e[-1]) & 0xc0) == 0x80)
+      e -= 1;
+    else
+      break;
+
+  if(e > p && static_cast<uchar> (e[-1]) >= 0xc0)
+    {
+      uchar c = static_cast<uchar> (e[-1]);
+      int length = (c & 0xe0) == 0xc0 ? 2 : (c & 0xf0) == 0xe0 ? 3 : 4;
+
+      if(end - (e - 1) < length)
+	end = e - 1;
+    }
+
+  for(e = end; e > p && end - e <= 10; e--)
+    if(e[-1] == ';')
+      break;
+    else if(e[-1] == '&')
+      return e - 1;
+
+  return end;
+}
+
+void pandamonium_kernel_parser::setTitle(void)
+{
+  if(!m_titleFound)
+    {
+      m_title = m_titleBytes.trimmed();
+      m_titleFound = true;
+    }
+
+  m_titleBytes.clear();
+}
+
+void pandamonium_kernel_parser::setExtractText(const bool state)
+{
+  m_extractText = state;
+}
@@ -0,0 +1,106 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_parser_h_
+#define _pandamonium_kernel_parser_h_
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+/*
+** A single-pass HTML tokenizer. The document is walked once, in place.
+** Tag and attribute names are compared without regard to case and
+** without copies. Only the values which are of interest are copied:
+** the title, the targets of anchors, and the contents of the description
+** and keywords meta tags. The contents of script and style elements
+** are skipped. If requested, the visible text is decoded (UTF-8 and
+** character references) directly into UTF-16.
+**
+** The parser may be fed a document in chunks. A chunk is consumed up to
+** the last complete token; the remainder is carried over to the next
+** chunk. finish() concludes the document. An incomplete tag which
+** exceeds s_maximumTagSize bytes is not carried over; it is discarded
+** through its closing '>'.
+*/
+
+class pandamonium_kernel_parser
+{
+ public:
+  pandamonium_kernel_parser(void);
+  QByteArray title(void) const;
+  QList<QByteArray> links(void) const;
+  QList<QByteArray> metaData(void) const;
+  QString text(void) const;
+  bool isHeadComplete(void) const;
+  void clear(void);
+  void feed(const QByteArray &content);
+  void finish(void);
+  void parse(const QByteArray &content);
+  void setExtractText(const bool state);
+
+ private:
+  enum Tags
+  {
+    A = 0,
+    Inline,
+    Meta,
+    Other,
+    Script,
+    Style,
+    Title
+  };
+
+  QByteArray m_buffer;
+  QByteArray m_title;
+  QByteArray m_titleBytes;
+  QList<QByteArray> m_links;
+  QList<QByteArray> m_metaData;
+  QString m_text;
+  Tags m_rawText;
+  bool m_extractText;
+  bool m_final;
+  bool m_headComplete;
+  bool m_skipTag;
+  bool m_titleFound;
+  static const int s_maximumTagSize = 65536;
+  static Tags tag(const char *name, const int length);
+  static bool equals(const char *a, const int length, const char *lowercase);
+  static const char *endTag(const char *p,
+			    const char *end,
+			    const char *lowercase);
+  const char *appendReference(const char *p, const char *end);
+  const char *parseTag(const char *p, const char *end);
+  const char *process(const char *p, const char *end);
+  const char *textBoundary(const char *p, const char *end) const;
+  void appendCodePoint(const uint c);
+  void appendSpace(void);
+  void appendText(const char *p, const char *end);
+  void setTitle(void);
+};
+
+#endif
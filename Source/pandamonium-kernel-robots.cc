@@ -0,0 +1,398 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDateTime>
+#include <QNetworkRequest>
+#include <QSettings>
+
+#include <algorithm>
+
+#include "pandamonium-kernel.h"
+#include "pandamonium-kernel-decoder.h"
+#include "pandamonium-kernel-robots.h"
+
+static bool sortRules(const pandamonium_kernel_robots_rule &a,
+		      const pandamonium_kernel_robots_rule &b)
+{
+  if(a.m_length != b.m_length)
+    return a.m_length > b.m_length;
+  else
+    return a.m_allow && !b.m_allow;
+}
+
+pandamonium_kernel_robots::pandamonium_kernel_robots(QObject *parent):
+  QObject(parent)
+{
+  m_ttl = 1000 * qBound
+    (static_cast<qint64> (60),
+     QSettings().value("pandamonium_robots_ttl", 86400).toLongLong(),
+     static_cast<qint64> (2592000));
+}
+
+pandamonium_kernel_robots::~pandamonium_kernel_robots()
+{
+}
+
+QByteArray pandamonium_kernel_robots::pathOf(const QUrl &url)
+{
+  QByteArray path
+    (url.toEncoded(QUrl::RemoveScheme |
+		   QUrl::RemoveAuthority |
+		   QUrl::RemoveFragment));
+
+  if(!path.startsWith('/'))
+    path.prepend('/');
+
+  return path;
+}
+
+QList<pandamonium_kernel_robots_rule> pandamonium_kernel_robots::parse
+(const QByteArray &bytes,
+ const QByteArray &agent,
+ QList<QUrl> &sitemaps,
+ qint64 &crawlDelay)
+{
+  /*
+  ** Consecutive User-agent lines begin a group. The groups which name
+  ** the agent are preferred to the groups of *. Sitemap lines do not
+  ** belong to groups.
+  */
+
+  QList<QByteArray> lines(bytes.split('\n'));
+  QList<pandamonium_kernel_robots_rule> rules[2]; // Agent, *.
+  bool agents = false;
+  bool found = false;
+  bool group[2] = {false, false};
+  qint64 delays[2] = {0, 0};
+
+  for(int i = 0; i < lines.size(); i++)
+    {
+      QByteArray line(lines.at(i));
+      int index = line.indexOf('#');
+
+      if(index >= 0)
+	line.truncate(index);
+
+      index = line.indexOf(':');
+
+      if(index <= 0)
+	continue;
+
+      QByteArray key(line.mid(0, index).trimmed().toLower());
+      QByteArray value(line.mid(index + 1).trimmed());
+
+      if(key == "sitemap")
+	{
+	  QUrl url(QUrl::fromEncoded(value));
+
+	  if(!url.isEmpty() && url.isValid())
+	    sitemaps << url;
+
+	  continue;
+	}
+      else if(key == "user-agent")
+	{
+	  if(!agents)
+	    group[0] = group[1] = false;
+
+	  agents = true;
+	  value = value.toLower();
+
+	  if(value == "*")
+	    group[1] = true;
+	  else if(value.split('/').value(0) == agent)
+	    {
+	      found = true;
+	      group[0] = true;
+	    }
+
+	  continue;
+	}
+
+      agents = false;
+
+      if(key == "allow" || key == "disallow")
+	{
+	  if(value.isEmpty())
+	    continue; // An empty Disallow allows everything.
+
+	  pandamonium_kernel_robots_rule rule;
+
+	  rule.m_allow = key == "allow";
+	  rule.m_anchored = value.endsWith('$');
+
+	  if(rule.m_anchored)
+	    value.chop(1);
+
+	  rule.m_length = value.length();
+	  rule.m_segments = value.split('*');
+
+	  for(int j = 0; j < 2; j++)
+	    if(group[j])
+	      rules[j] << rule;
+	}
+      else if(key == "crawl-delay")
+	{
+	  bool ok = true;
+	  double seconds = value.toDouble(&ok);
+
+	  if(ok && seconds > 0.0)
+	    for(int j = 0; j < 2; j++)
+	      if(group[j])
+		delays[j] = static_cast<qint64>
+		  (1000.0 * qMin(seconds, 3600.0));
+	}
+    }
+
+  int j = found ? 0 : 1;
+
+  std::stable_sort(rules[j].begin(), rules[j].end(), sortRules);
+  crawlDelay = delays[j];
+  return rules[j];
+}
+
+QString pandamonium_kernel_robots::originOf(const QUrl &url)
+{
+  if(url.host().isEmpty())
+    return QString();
+
+  QString origin(url.scheme().toLower() + "://" + url.host().toLower());
+
+  if(url.port() != -1)
+    origin.append(QString(":%1").arg(url.port()));
+
+  return origin;
+}
+
+pandamonium_kernel_robots::States pandamonium_kernel_robots::state
+(const QUrl &url)
+{
+  QString origin(originOf(url));
+
+  if(origin.isEmpty())
+    return Allowed;
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  if(!m_entries.contains(origin))
+    {
+      fetch(origin);
+      return Pending;
+    }
+
+  const pandamonium_kernel_robots_entry &entry(m_entries[origin]);
+
+  if(entry.m_state == pandamonium_kernel_robots_entry::Fetching)
+    return Pending;
+  else if(entry.m_expiration <= now)
+    {
+      if(entry.m_state == pandamonium_kernel_robots_entry::Ready)
+	{
+	  /*
+	  ** The expired rules remain in effect while the file is
+	  ** requested again.
+	  */
+
+	  States state = isAllowed(entry.m_rules, pathOf(url)) ?
+	    Allowed : Disallowed;
+
+	  fetch(origin);
+	  return state;
+	}
+
+      fetch(origin);
+      return Pending;
+    }
+  else if(entry.m_state == pandamonium_kernel_robots_entry::Unreachable)
+    return Pending;
+
+  return isAllowed(entry.m_rules, pathOf(url)) ? Allowed : Disallowed;
+}
+
+bool pandamonium_kernel_robots::isAllowed
+(const QList<pandamonium_kernel_robots_rule> &rules, const QByteArray &path)
+{
+  for(int i = 0; i < rules.size(); i++)
+    if(matches(rules.at(i), path))
+      return rules.at(i).m_allow;
+
+  return true;
+}
+
+bool pandamonium_kernel_robots::isDisallowed(const QUrl &url) const
+{
+  /*
+  ** Only cached rules are consulted.
+  */
+
+  QHash<QString, pandamonium_kernel_robots_entry>::const_iterator it
+    (m_entries.constFind(originOf(url)));
+
+  if(it == m_entries.constEnd())
+    return false;
+  else if(it.value().m_state != pandamonium_kernel_robots_entry::Ready)
+    return false;
+
+  return !isAllowed(it.value().m_rules, pathOf(url));
+}
+
+bool pandamonium_kernel_robots::matches
+(const pandamonium_kernel_robots_rule &rule, const QByteArray &path)
+{
+  const QList<QByteArray> &segments(rule.m_segments);
+
+  if(segments.size() == 1)
+    {
+      if(rule.m_anchored)
+	return path == segments.at(0);
+      else
+	return path.startsWith(segments.at(0));
+    }
+
+  /*
+  ** The first segment is a prefix. The remaining segments are located
+  ** from left to right. The last segment of an anchored pattern must
+  ** also end the path.
+  */
+
+  if(!path.startsWith(segments.at(0)))
+    return false;
+
+  int position = segments.at(0).length();
+
+  for(int i = 1; i < segments.size(); i++)
+    {
+      const QByteArray &segment(segments.at(i));
+
+      if(i == segments.size() - 1 && rule.m_anchored)
+	return path.length() - segment.length() >= position &&
+	  path.endsWith(segment);
+
+      if(segment.isEmpty())
+	continue;
+
+      int index = path.indexOf(segment, position);
+
+      if(index < 0)
+	return false;
+
+      position = index + segment.length();
+    }
+
+  return true;
+}
+
+qint64 pandamonium_kernel_robots::crawlDelay(const QUrl &url) const
+{
+  return m_entries.value(originOf(url)).m_crawlDelay;
+}
+
+void pandamonium_kernel_robots::fetch(const QString &origin)
+{
+  if(m_replies.values().contains(origin))
+    return;
+
+  QNetworkRequest request(QUrl(origin + "/robots.txt"));
+
+#if QT_VERSION >= 0x050600
+  request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+#endif
+
+  QNetworkReply *reply = pandamonium_kernel::get(request);
+
+  if(!m_entries.contains(origin))
+    m_entries[origin] = pandamonium_kernel_robots_entry();
+
+  m_replies[reply] = origin;
+  reply->setParent(this);
+  connect(reply,
+	  SIGNAL(finished(void)),
+	  this,
+	  SLOT(slotFinished(void)));
+}
+
+void pandamonium_kernel_robots::prune(const qint64 now)
+{
+  QMutableHashIterator<QString, pandamonium_kernel_robots_entry>
+    it(m_entries);
+
+  while(it.hasNext())
+    {
+      it.next();
+
+      if(it.value().m_state != pandamonium_kernel_robots_entry::Fetching)
+	if(it.value().m_expiration + m_ttl <= now)
+	  it.remove();
+    }
+}
+
+void pandamonium_kernel_robots::slotFinished(void)
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply *> (sender());
+
+  if(!reply)
+    return;
+
+  QString origin(m_replies.take(reply));
+  int status = reply->attribute
+    (QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  QList<QUrl> urls;
+  pandamonium_kernel_robots_entry &entry(m_entries[origin]);
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  entry.m_crawlDelay = 0;
+  entry.m_expiration = now + m_ttl;
+  entry.m_rules.clear();
+  entry.m_state = pandamonium_kernel_robots_entry::Ready;
+
+  if(reply->error() == QNetworkReply::NoError && status >= 200 && status < 300)
+    {
+      pandamonium_kernel_decoder decoder(reply->rawHeader("Content-Encoding"));
+
+      entry.m_rules = parse
+	(decoder.decode(reply->read(s_maximumSize)).left(s_maximumSize),
+	 "pandamonium",
+	 urls,
+	 entry.m_crawlDelay);
+    }
+  else if(status >= 400 && status < 500)
+    {
+      /*
+      ** A missing robots.txt allows everything.
+      */
+    }
+  else
+    {
+      entry.m_expiration = now + s_retryInterval;
+      entry.m_state = pandamonium_kernel_robots_entry::Unreachable;
+    }
+
+  reply->deleteLater();
+
+  if(entry.m_state == pandamonium_kernel_robots_entry::Ready)
+    emit sitemaps(origin, urls);
+}
@@ -0,0 +1,131 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_robots_h_
+#define _pandamonium_kernel_robots_h_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QNetworkReply>
+#include <QObject>
+#include <QString>
+#include <QUrl>
+
+class pandamonium_kernel_robots_rule
+{
+ public:
+  pandamonium_kernel_robots_rule(void)
+  {
+    m_allow = false;
+    m_anchored = false;
+    m_length = 0;
+  }
+
+  QList<QByteArray> m_segments; // The pattern, split on *.
+  bool m_allow;
+  bool m_anchored; // The pattern ends with $.
+  int m_length;
+};
+
+class pandamonium_kernel_robots_entry
+{
+ public:
+  enum States
+  {
+    Fetching = 0,
+    Ready,
+    Unreachable
+  };
+
+  pandamonium_kernel_robots_entry(void)
+  {
+    m_crawlDelay = 0;
+    m_expiration = 0;
+    m_state = Fetching;
+  }
+
+  QList<pandamonium_kernel_robots_rule> m_rules;
+  States m_state;
+  qint64 m_crawlDelay; // Milliseconds.
+  qint64 m_expiration; // Milliseconds since the epoch.
+};
+
+/*
+** A cache of robots.txt rules, one entry per origin. Entries expire
+** after pandamonium_robots_ttl seconds. Unreachable robots.txt files
+** are requested again after five minutes. The rules of an origin are
+** sorted so that the first matching rule is also the longest; Allow
+** precedes Disallow if the lengths are equal.
+*/
+
+class pandamonium_kernel_robots: public QObject
+{
+  Q_OBJECT
+
+ public:
+  enum States
+  {
+    Allowed = 0,
+    Disallowed,
+    Pending
+  };
+
+  pandamonium_kernel_robots(QObject *parent);
+  ~pandamonium_kernel_robots();
+  States state(const QUrl &url);
+  bool isDisallowed(const QUrl &url) const;
+  qint64 crawlDelay(const QUrl &url) const;
+  static QString originOf(const QUrl &url);
+  void prune(const qint64 now);
+
+ private:
+  QHash<QNetworkReply *, QString> m_replies;
+  QHash<QString, pandamonium_kernel_robots_entry> m_entries;
+  qint64 m_ttl;
+  static const int s_maximumSize = 524288;
+  static const qint64 s_retryInterval = 300000;
+  static QByteArray pathOf(const QUrl &url);
+  static QList<pandamonium_kernel_robots_rule> parse
+    (const QByteArray &bytes,
+     const QByteArray &agent,
+     QList<QUrl> &sitemaps,
+     qint64 &crawlDelay);
+  static bool isAllowed(const QList<pandamonium_kernel_robots_rule> &rules,
+			const QByteArray &path);
+  static bool matches(const pandamonium_kernel_robots_rule &rule,
+		      const QByteArray &path);
+  void fetch(const QString &origin);
+
+ private slots:
+  void slotFinished(void);
+
+ signals:
+  void sitemaps(const QString &origin, const QList<QUrl> &urls);
+};
+
+#endif
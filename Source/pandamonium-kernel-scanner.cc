@@ -0,0 +1,213 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define PANDAMONIUM_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "pandamonium-kernel-scanner.h"
+
+/*
+** Every implementation returns end if none of a, b, c, d is found.
+*/
+
+static const char *findScalar(const char *p,
+			      const char *end,
+			      const char a,
+			      const char b,
+			      const char c,
+			      const char d)
+{
+  for(; p < end; p++)
+    if(*p == a || *p == b || *p == c || *p == d)
+      return p;
+
+  return end;
+}
+
+#ifdef PANDAMONIUM_X86_SIMD
+__attribute__((target("sse2")))
+static const char *findSSE2(const char *p,
+			    const char *end,
+			    const char a,
+			    const char b,
+			    const char c,
+			    const char d)
+{
+  __m128i va = _mm_set1_epi8(a);
+  __m128i vb = _mm_set1_epi8(b);
+  __m128i vc = _mm_set1_epi8(c);
+  __m128i vd = _mm_set1_epi8(d);
+
+  while(end - p >= 16)
+    {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *> (p));
+      int mask = _mm_movemask_epi8
+	(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va),
+				   _mm_cmpeq_epi8(x, vb)),
+		      _mm_or_si128(_mm_cmpeq_epi8(x, vc),
+				   _mm_cmpeq_epi8(x, vd))));
+
+      if(mask)
+	return p + __builtin_ctz(static_cast<unsigned int> (mask));
+
+      p += 16;
+    }
+
+  return findScalar(p, end, a, b, c, d);
+}
+
+__attribute__((target("avx2")))
+static const char *findAVX2(const char *p,
+			    const char *end,
+			    const char a,
+			    const char b,
+			    const char c,
+			    const char d)
+{
+  __m256i va = _mm256_set1_epi8(a);
+  __m256i vb = _mm256_set1_epi8(b);
+  __m256i vc = _mm256_set1_epi8(c);
+  __m256i vd = _mm256_set1_epi8(d);
+
+  while(end - p >= 32)
+    {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (p));
+      int mask = _mm256_movemask_epi8
+	(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, va),
+					 _mm256_cmpeq_epi8(x, vb)),
+			 _mm256_or_si256(_mm256_cmpeq_epi8(x, vc),
+					 _mm256_cmpeq_epi8(x, vd))));
+
+      if(mask)
+	return p + __builtin_ctz(static_cast<unsigned int> (mask));
+
+      p += 32;
+    }
+
+  return findSSE2(p, end, a, b, c, d);
+}
+#endif
+
+static pandamonium_kernel_scanner::Implementations automaticImplementation
+(void)
+{
+#ifdef PANDAMONIUM_X86_SIMD
+  __builtin_cpu_init();
+
+  if(__builtin_cpu_supports("avx2"))
+    return pandamonium_kernel_scanner::AVX2;
+  else if(__builtin_cpu_supports("sse2"))
+    return pandamonium_kernel_scanner::SSE2;
+#endif
+  return pandamonium_kernel_scanner::Scalar;
+}
+
+static pandamonium_kernel_scanner::find_function function
+(const pandamonium_kernel_scanner::Implementations implementation)
+{
+  switch(implementation)
+    {
+#ifdef PANDAMONIUM_X86_SIMD
+    case pandamonium_kernel_scanner::AVX2:
+      {
+	return findAVX2;
+      }
+    case pandamonium_kernel_scanner::SSE2:
+      {
+	return findSSE2;
+      }
+#endif
+    default:
+      {
+	return findScalar;
+      }
+    }
+}
+
+pandamonium_kernel_scanner::Implementations
+pandamonium_kernel_scanner::s_implementation = automaticImplementation();
+pandamonium_kernel_scanner::find_function
+pandamonium_kernel_scanner::s_find = function(s_implementation);
+
+QString pandamonium_kernel_scanner::implementationName(void)
+{
+  switch(s_implementation)
+    {
+    case AVX2:
+      {
+	return "AVX2";
+      }
+    case SSE2:
+      {
+	return "SSE2";
+      }
+    default:
+      {
+	return "Scalar";
+      }
+    }
+}
+
+bool pandamonium_kernel_scanner::setImplementation
+(const Implementations implementation)
+{
+  /*
+  ** Not thread-safe. Intended for benchmarks.
+  */
+
+  Implementations i = implementation;
+
+  if(i == Automatic)
+    i = automaticImplementation();
+  else if(!supports(i))
+    return false;
+
+  s_find = function(i);
+  s_implementation = i;
+  return true;
+}
+
+bool pandamonium_kernel_scanner::supports(const Implementations implementation)
+{
+  switch(implementation)
+    {
+    case AVX2:
+      {
+	return automaticImplementation() == AVX2;
+      }
+    case SSE2:
+      {
+	return automaticImplementation() != Scalar;
+      }
+    default:
+      {
+	return true;
+      }
+    }
+}
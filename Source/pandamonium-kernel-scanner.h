@@ -0,0 +1,95 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_scanner_h_
+#define _pandamonium_kernel_scanner_h_
+
+#include <QString>
+
+/*
+** Locates the next structural byte of a document. The widest
+** implementation which the processor supports is selected at run time:
+** AVX2 (32 bytes per step), SSE2 (16 bytes per step), or a portable
+** scalar loop.
+*/
+
+class pandamonium_kernel_scanner
+{
+ public:
+  enum Implementations
+  {
+    AVX2 = 0,
+    Automatic,
+    SSE2,
+    Scalar
+  };
+
+  typedef const char *(*find_function) (const char *p,
+					const char *end,
+					const char a,
+					const char b,
+					const char c,
+					const char d);
+
+  static QString implementationName(void);
+  static bool setImplementation(const Implementations implementation);
+  static bool supports(const Implementations implementation);
+
+  static const char *find(const char *p, const char *end, const char c)
+  {
+    return s_find(p, end, c, c, c, c);
+  }
+
+  static const char *find(const char *p,
+			  const char *end,
+			  const char a,
+			  const char b,
+			  const char c)
+  {
+    return s_find(p, end, a, b, c, c);
+  }
+
+  static const char *find(const char *p,
+			  const char *end,
+			  const char a,
+			  const char b,
+			  const char c,
+			  const char d)
+  {
+    return s_find(p, end, a, b, c, d);
+  }
+
+ private:
+  pandamonium_kernel_scanner(void)
+  {
+  }
+
+  static Implementations s_implementation;
+  static find_function s_find;
+};
+
+#endif
@@ -0,0 +1,259 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <functional>
+
+#include "pandamonium-kernel-scheduler.h"
+
+pandamonium_kernel_scheduler::pandamonium_kernel_scheduler(void)
+{
+  m_overflowSize = 0;
+}
+
+pandamonium_kernel_scheduler::~pandamonium_kernel_scheduler()
+{
+}
+
+QString pandamonium_kernel_scheduler::hostOf(const QUrl &url)
+{
+  return url.host().toLower().trimmed();
+}
+
+pandamonium_frontier_entry pandamonium_kernel_scheduler::dequeue
+(const qint64 now, const qint64 interval)
+{
+  while(!m_heap.isEmpty())
+    {
+      heap_item item(m_heap.first());
+      qint64 nextAllowed = m_nextAllowed.value(item.second, 0);
+
+      if(item.first < nextAllowed)
+	{
+	  /*
+	  ** The host's delay was extended after it was placed on the heap.
+	  */
+
+	  pop();
+	  push(nextAllowed, item.second);
+	  continue;
+	}
+
+      if(item.first > now)
+	break;
+
+      pop();
+
+      QQueue<pandamonium_frontier_entry> &queue(m_queues[item.second]);
+
+      if(queue.isEmpty())
+	{
+	  m_queues.remove(item.second);
+	  continue;
+	}
+
+      pandamonium_frontier_entry entry(queue.dequeue());
+
+      m_nextAllowed[item.second] = now + qMax
+	(m_crawlDelays.value(item.second, 0),
+	 qMax(static_cast<qint64> (0), interval));
+      m_queued.remove(entry.m_url);
+
+      if(m_overflow.contains(item.second))
+	{
+	  QQueue<pandamonium_frontier_entry> &overflow
+	    (m_overflow[item.second]);
+
+	  while(!overflow.isEmpty())
+	    {
+	      pandamonium_frontier_entry e(overflow.dequeue());
+
+	      m_overflowSize -= 1;
+
+	      if(!m_queued.contains(e.m_url))
+		{
+		  m_queued.insert(e.m_url);
+		  queue.enqueue(e);
+		  break;
+		}
+	    }
+
+	  if(overflow.isEmpty())
+	    m_overflow.remove(item.second);
+	}
+
+      if(queue.isEmpty())
+	m_queues.remove(item.second);
+      else
+	push(m_nextAllowed.value(item.second), item.second);
+
+      return entry;
+    }
+
+  return pandamonium_frontier_entry();
+}
+
+bool pandamonium_kernel_scheduler::contains(const QUrl &url) const
+{
+  return m_queued.contains(url);
+}
+
+bool pandamonium_kernel_scheduler::enqueue
+(const pandamonium_frontier_entry &entry)
+{
+  if(entry.m_url.isEmpty() || !entry.m_url.isValid())
+    return false;
+  else if(m_queued.contains(entry.m_url))
+    return false;
+
+  QString host(hostOf(entry.m_url));
+
+  if(host.isEmpty())
+    return false;
+
+  m_queued.insert(entry.m_url);
+
+  if(!m_queues.contains(host))
+    {
+      /*
+      ** The host is not on the heap.
+      */
+
+      m_queues[host].enqueue(entry);
+      push(m_nextAllowed.value(host, 0), host);
+    }
+  else
+    m_queues[host].enqueue(entry);
+
+  return true;
+}
+
+bool pandamonium_kernel_scheduler::isHostFull(const QUrl &url) const
+{
+  return m_queues.value(hostOf(url)).size() >= s_maximumHostQueue;
+}
+
+bool pandamonium_kernel_scheduler::isReady(const qint64 now) const
+{
+  return !m_heap.isEmpty() && m_heap.first().first <= now;
+}
+
+bool pandamonium_kernel_scheduler::park
+(const pandamonium_frontier_entry &entry)
+{
+  if(m_overflowSize >= s_maximumOverflow)
+    return false;
+
+  QString host(hostOf(entry.m_url));
+
+  if(host.isEmpty() || !m_queues.contains(host))
+    return false;
+
+  QQueue<pandamonium_frontier_entry> &overflow(m_overflow[host]);
+
+  if(overflow.size() >= s_maximumHostOverflow)
+    return false;
+
+  overflow.enqueue(entry);
+  m_overflowSize += 1;
+  return true;
+}
+
+int pandamonium_kernel_scheduler::hosts(void) const
+{
+  return m_queues.size();
+}
+
+int pandamonium_kernel_scheduler::size(void) const
+{
+  return m_queued.size();
+}
+
+void pandamonium_kernel_scheduler::pop(void)
+{
+  if(m_heap.isEmpty())
+    return;
+
+  std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<heap_item> ());
+  m_heap.removeLast();
+}
+
+void pandamonium_kernel_scheduler::prune(const qint64 now)
+{
+  /*
+  ** Discard the delays of idle hosts which have expired. Crawl delays
+  ** are restored as the hosts are contacted again.
+  */
+
+  QMutableHashIterator<QString, qint64> it(m_nextAllowed);
+
+  while(it.hasNext())
+    {
+      it.next();
+
+      if(it.value() <= now && !m_queues.contains(it.key()))
+	{
+	  m_crawlDelays.remove(it.key());
+	  it.remove();
+	}
+    }
+}
+
+void pandamonium_kernel_scheduler::push(const qint64 time, const QString &host)
+{
+  m_heap.append(heap_item(time, host));
+  std::push_heap(m_heap.begin(), m_heap.end(), std::greater<heap_item> ());
+}
+
+void pandamonium_kernel_scheduler::reset(void)
+{
+  /*
+  ** The queued URLs are discarded. The hosts' delays are retained.
+  */
+
+  m_heap.clear();
+  m_overflow.clear();
+  m_overflowSize = 0;
+  m_queued.clear();
+  m_queues.clear();
+}
+
+void pandamonium_kernel_scheduler::setCrawlDelay
+(const QString &host, const qint64 delay)
+{
+  if(delay > 0)
+    m_crawlDelays[host] = delay;
+  else
+    m_crawlDelays.remove(host);
+}
+
+void pandamonium_kernel_scheduler::setHostDelay
+(const QString &host, const qint64 time)
+{
+  if(m_nextAllowed.value(host, 0) < time)
+    m_nextAllowed[host] = time;
+}
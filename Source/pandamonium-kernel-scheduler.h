@@ -0,0 +1,87 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_scheduler_h_
+#define _pandamonium_kernel_scheduler_h_
+
+#include <QHash>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+#include "pandamonium-kernel-frontier.h"
+
+/*
+** A kernel-wide scheduler of hosts. Each host owns a queue of pending
+** URLs. Hosts which have pending URLs are placed on a min-heap which is
+** ordered by the next time, in milliseconds since the epoch, that a host
+** may be contacted. URLs of hosts whose queues are full may be parked
+** in a bounded overflow. A parked URL replaces a URL which is dequeued
+** from its host's queue.
+*/
+
+class pandamonium_kernel_scheduler
+{
+ public:
+  pandamonium_kernel_scheduler(void);
+  ~pandamonium_kernel_scheduler();
+  bool contains(const QUrl &url) const;
+  bool enqueue(const pandamonium_frontier_entry &entry);
+  bool isHostFull(const QUrl &url) const;
+  bool isReady(const qint64 now) const;
+  bool park(const pandamonium_frontier_entry &entry);
+  int hosts(void) const;
+  int size(void) const;
+  static QString hostOf(const QUrl &url);
+  pandamonium_frontier_entry dequeue(const qint64 now,
+				     const qint64 interval);
+  void prune(const qint64 now);
+  void reset(void);
+  void setCrawlDelay(const QString &host, const qint64 delay);
+  void setHostDelay(const QString &host, const qint64 time);
+
+ private:
+  typedef QPair<qint64, QString> heap_item;
+
+  QHash<QString, QQueue<pandamonium_frontier_entry> > m_overflow;
+  QHash<QString, QQueue<pandamonium_frontier_entry> > m_queues;
+  QHash<QString, qint64> m_crawlDelays;
+  QHash<QString, qint64> m_nextAllowed;
+  QSet<QUrl> m_queued;
+  QVector<heap_item> m_heap;
+  int m_overflowSize;
+  static const int s_maximumHostOverflow = 256;
+  static const int s_maximumHostQueue = 64;
+  static const int s_maximumOverflow = 4096;
+  void pop(void);
+  void push(const qint64 time, const QString &host);
+};
+
+#endif
@@ -0,0 +1,301 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDateTime>
+#include <QNetworkRequest>
+
+#include "pandamonium-kernel.h"
+#include "pandamonium-kernel-sitemap.h"
+
+pandamonium_kernel_sitemap::pandamonium_kernel_sitemap(QObject *parent):
+  QObject(parent)
+{
+}
+
+pandamonium_kernel_sitemap::~pandamonium_kernel_sitemap()
+{
+  flush();
+}
+
+void pandamonium_kernel_sitemap::consume
+(QNetworkReply *reply, pandamonium_kernel_sitemap_fetch &fetch)
+{
+  QByteArray bytes(reply->readAll());
+
+  if(bytes.isEmpty() || !fetch.m_reader)
+    return;
+
+  if(!fetch.m_decoder)
+    {
+      /*
+      ** A .gz sitemap without a Content-Encoding is a gzip file.
+      */
+
+      QByteArray encoding(reply->rawHeader("Content-Encoding"));
+      QString type
+	(reply->header(QNetworkRequest::ContentTypeHeader).toString().
+	 toLower());
+
+      if(encoding.trimmed().isEmpty())
+	if(reply->url().path().toLower().endsWith(".gz") ||
+	   type.contains("gzip"))
+	  encoding = "gzip";
+
+      fetch.m_decoder = QSharedPointer<pandamonium_kernel_decoder>
+	(new pandamonium_kernel_decoder(encoding));
+    }
+
+  QByteArray decoded(fetch.m_decoder->decode(bytes));
+
+  if(fetch.m_decoder->hasError())
+    {
+      fetch.m_reader.clear();
+      return;
+    }
+
+  fetch.m_decodedBytes += decoded.size();
+
+  if(fetch.m_decodedBytes > s_maximumSize)
+    {
+      fetch.m_reader.clear();
+      return;
+    }
+
+  fetch.m_reader->addData(decoded);
+  read(fetch);
+}
+
+void pandamonium_kernel_sitemap::flush(void)
+{
+  if(!m_urls.isEmpty())
+    {
+      pandamonium_kernel::markUrlsAsUnvisited
+	(pandamonium_kernel::canonicalize(m_urls), 1, 0);
+      m_urls.clear();
+    }
+
+  if(!m_modified.isEmpty())
+    {
+      pandamonium_kernel::markUrlsAsModified(m_modified);
+      m_modified.clear();
+    }
+}
+
+void pandamonium_kernel_sitemap::load
+(const QUrl &url, const QString &host, const int level)
+{
+  if(url.isEmpty() || !url.isValid())
+    return;
+  else if(url.scheme() != "http" && url.scheme() != "https")
+    return;
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  if(m_loaded.contains(url) && m_loaded.value(url) > now)
+    return;
+
+  QNetworkRequest request(url);
+
+#if QT_VERSION >= 0x050600
+  request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+#endif
+
+  QNetworkReply *reply = pandamonium_kernel::get(request);
+  pandamonium_kernel_sitemap_fetch fetch;
+
+  fetch.m_host = host.toLower();
+  fetch.m_level = level;
+  fetch.m_reader = QSharedPointer<QXmlStreamReader>(new QXmlStreamReader());
+  m_fetches[reply] = fetch;
+  m_loaded[url] = now + s_interval;
+  reply->setParent(this);
+  connect(reply,
+	  SIGNAL(finished(void)),
+	  this,
+	  SLOT(slotFinished(void)));
+  connect(reply,
+	  SIGNAL(readyRead(void)),
+	  this,
+	  SLOT(slotReadyRead(void)));
+}
+
+void pandamonium_kernel_sitemap::loadSitemaps(void)
+{
+  /*
+  ** The sitemaps of indexes are loaded once their parents' fetches
+  ** are no longer referenced.
+  */
+
+  while(!m_sitemaps.isEmpty())
+    {
+      QPair<QUrl, int> pair(m_sitemaps.takeFirst());
+
+      load(pair.first, pair.first.host(), pair.second);
+    }
+}
+
+void pandamonium_kernel_sitemap::prune(const qint64 now)
+{
+  QMutableHashIterator<QUrl, qint64> it(m_loaded);
+
+  while(it.hasNext())
+    {
+      it.next();
+
+      if(it.value() <= now)
+	it.remove();
+    }
+}
+
+void pandamonium_kernel_sitemap::read(pandamonium_kernel_sitemap_fetch &fetch)
+{
+  /*
+  ** Tokens are read until the available data has been exhausted.
+  ** QXmlStreamReader resumes once more data is added.
+  */
+
+  QXmlStreamReader *reader = fetch.m_reader.data();
+
+  while(!reader->atEnd())
+    {
+      QXmlStreamReader::TokenType token = reader->readNext();
+
+      if(token == QXmlStreamReader::Invalid)
+	{
+	  if(reader->error() != QXmlStreamReader::PrematureEndOfDocumentError)
+	    fetch.m_reader.clear();
+
+	  break;
+	}
+      else if(token == QXmlStreamReader::StartElement)
+	{
+	  QStringRef name(reader->name());
+
+	  if(name == "lastmod")
+	    fetch.m_field = pandamonium_kernel_sitemap_fetch::LastModified;
+	  else if(name == "loc")
+	    fetch.m_field = pandamonium_kernel_sitemap_fetch::Location;
+	  else if(name == "sitemap" || name == "url")
+	    {
+	      fetch.m_lastModified.clear();
+	      fetch.m_location.clear();
+	    }
+	}
+      else if(token == QXmlStreamReader::Characters)
+	{
+	  if(fetch.m_field == pandamonium_kernel_sitemap_fetch::LastModified)
+	    fetch.m_lastModified.append(reader->text());
+	  else if(fetch.m_field == pandamonium_kernel_sitemap_fetch::Location)
+	    fetch.m_location.append(reader->text());
+	}
+      else if(token == QXmlStreamReader::EndElement)
+	{
+	  QStringRef name(reader->name());
+
+	  fetch.m_field = pandamonium_kernel_sitemap_fetch::None;
+
+	  if(name != "sitemap" && name != "url")
+	    continue;
+
+	  QUrl url(fetch.m_location.trimmed());
+
+	  if(url.isEmpty() || !url.isValid())
+	    continue;
+	  else if(url.host().toLower() != fetch.m_host)
+	    continue;
+
+	  if(name == "sitemap")
+	    {
+	      if(fetch.m_level < s_maximumLevel)
+		m_sitemaps << QPair<QUrl, int> (url, fetch.m_level + 1);
+
+	      continue;
+	    }
+	  else if(pandamonium_kernel::isUrlDisallowed(url))
+	    continue;
+
+	  QDateTime dateTime
+	    (QDateTime::fromString(fetch.m_lastModified.trimmed(),
+				   Qt::ISODate));
+
+	  if(dateTime.isValid())
+	    m_modified << QPair<QUrl, qint64>
+	      (url, dateTime.toMSecsSinceEpoch() / 1000);
+
+	  m_urls << url;
+
+	  if(m_urls.size() >= s_batchSize)
+	    flush();
+	}
+    }
+}
+
+void pandamonium_kernel_sitemap::slotFinished(void)
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply *> (sender());
+
+  if(!reply)
+    return;
+
+  if(m_fetches.contains(reply))
+    {
+      pandamonium_kernel_sitemap_fetch fetch(m_fetches.take(reply));
+
+      if(reply->error() == QNetworkReply::NoError)
+	consume(reply, fetch);
+    }
+
+  flush();
+  loadSitemaps();
+  reply->deleteLater();
+}
+
+void pandamonium_kernel_sitemap::slotReadyRead(void)
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply *> (sender());
+
+  if(!reply || !m_fetches.contains(reply))
+    return;
+  else if(reply->error() != QNetworkReply::NoError)
+    return;
+
+  pandamonium_kernel_sitemap_fetch &fetch(m_fetches[reply]);
+
+  consume(reply, fetch);
+
+  if(!fetch.m_reader)
+    {
+      /*
+      ** The sitemap is malformed or too large.
+      */
+
+      m_fetches.remove(reply);
+      reply->abort();
+    }
+
+  loadSitemaps();
+}
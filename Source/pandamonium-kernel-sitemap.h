@@ -0,0 +1,106 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_sitemap_h_
+#define _pandamonium_kernel_sitemap_h_
+
+#include <QHash>
+#include <QList>
+#include <QNetworkReply>
+#include <QObject>
+#include <QPair>
+#include <QSharedPointer>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+#include "pandamonium-kernel-decoder.h"
+
+class pandamonium_kernel_sitemap_fetch
+{
+ public:
+  pandamonium_kernel_sitemap_fetch(void)
+  {
+    m_decodedBytes = 0;
+    m_field = None;
+    m_level = 0;
+  }
+
+  enum Fields
+  {
+    LastModified = 0,
+    Location,
+    None
+  };
+
+  QSharedPointer<QXmlStreamReader> m_reader;
+  QSharedPointer<pandamonium_kernel_decoder> m_decoder;
+  QString m_host; // Locations must belong to the host.
+  QString m_lastModified;
+  QString m_location;
+  Fields m_field;
+  int m_level; // Sitemap indexes increase the level.
+  qint64 m_decodedBytes;
+};
+
+/*
+** Reads sitemaps and sitemap indexes, including gzip-compressed
+** sitemaps, as they are downloaded. Locations are inserted in bulk into
+** pandamonium_visited_urls at depth 1. The lastmod values of parsed
+** URLs advance their revisits. A sitemap is read at most once per day.
+*/
+
+class pandamonium_kernel_sitemap: public QObject
+{
+  Q_OBJECT
+
+ public:
+  pandamonium_kernel_sitemap(QObject *parent);
+  ~pandamonium_kernel_sitemap();
+  void load(const QUrl &url, const QString &host, const int level = 0);
+  void prune(const qint64 now);
+
+ private:
+  QHash<QNetworkReply *, pandamonium_kernel_sitemap_fetch> m_fetches;
+  QHash<QUrl, qint64> m_loaded;
+  QList<QPair<QUrl, int> > m_sitemaps; // URL, level.
+  QList<QPair<QUrl, qint64> > m_modified;
+  QList<QUrl> m_urls;
+  static const int s_batchSize = 1024;
+  static const int s_maximumLevel = 1;
+  static const qint64 s_interval = 86400000;
+  static const qint64 s_maximumSize = 52428800;
+  void consume(QNetworkReply *reply, pandamonium_kernel_sitemap_fetch &fetch);
+  void flush(void);
+  void loadSitemaps(void);
+  void read(pandamonium_kernel_sitemap_fetch &fetch);
+
+ private slots:
+  void slotFinished(void);
+  void slotReadyRead(void);
+};
+
+#endif
@@ -25,13 +25,16 @@
 ** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <QTextDocument>
+#include <QSet>
+#include <QSettings>
 #include <QTimer>
 #include <QtDebug>
 
+#include <algorithm>
+
 #include "pandamonium-common.h"
-#include "pandamonium-database.h"
 #include "pandamonium-kernel.h"
+#include "pandamonium-kernel-parser.h"
 #include "pandamonium-kernel-url.h"
 
 static bool sortStringListByLength(const QString &a, const QString &b)
@@ -41,39 +44,66 @@ static bool sortStringListByLength(const QString &a, const QString &b)
 
 pandamonium_kernel_url::pandamonium_kernel_url
 (const QUrl &url, const bool paused, const double request_interval,
- const int search_depth, QObject *parent):
+ const int concurrency, const int search_depth, QObject *parent):
   QObject(parent)
 {
-  m_abortTimer.setInterval(10000);
-  m_isLoaded = false;
+  m_abortTimer.setInterval(1000);
+  m_concurrency = qBound(1, concurrency, 16);
+  m_headOnly = false;
+  m_metaDataOnly = true;
+  m_maximumContentLength = qMax
+    (static_cast<qint64> (s_maximumHeadSize),
+     QSettings().value("pandamonium_maximum_content_length", 16777216).
+     toLongLong());
   m_paused = paused;
   m_requestInterval = qBound(0.100, request_interval, 100.00);
   m_searchDepth = search_depth;
-  m_url = m_urlToLoad = url;
+  m_seed = static_cast<qint64>
+    (pandamonium_common::hash(pandamonium_common::toEncoded(url)));
+  m_url = url;
   connect(&m_abortTimer,
 	  SIGNAL(timeout(void)),
 	  this,
 	  SLOT(slotAbortTimeout(void)));
-  connect(&m_loadNextTimer,
-	  SIGNAL(timeout(void)),
-	  this,
-	  SLOT(slotLoadNext(void)));
+  m_abortTimer.start();
+}
 
-  if(!m_paused)
-    {
-      m_abortTimer.start();
+pandamonium_kernel_url::~pandamonium_kernel_url()
+{
+}
 
-      QNetworkReply *reply = pandamonium_kernel::get(QNetworkRequest(m_url));
+QUrl pandamonium_kernel_url::url(void) const
+{
+  return m_url;
+}
 
-      reply->setParent(this);
-      connectReplySignals(reply);
-    }
+bool pandamonium_kernel_url::hasCapacity(void) const
+{
+  return !m_paused && m_fetches.size() < m_concurrency;
+}
 
-  m_loadNextTimer.setInterval(static_cast<int> (1000 * m_requestInterval));
+bool pandamonium_kernel_url::isIdle(void) const
+{
+  return m_fetches.isEmpty();
 }
 
-pandamonium_kernel_url::~pandamonium_kernel_url()
+double pandamonium_kernel_url::requestInterval(void) const
+{
+  return m_requestInterval;
+}
+
+int pandamonium_kernel_url::searchDepth(void) const
 {
+  return m_searchDepth;
+}
+
+qint64 pandamonium_kernel_url::seed(void) const
+{
+  /*
+  ** Identifies the search URL in pandamonium_visited_urls.
+  */
+
+  return m_seed;
 }
 
 void pandamonium_kernel_url::connectReplySignals(QNetworkReply *reply)
@@ -91,6 +121,11 @@ void pandamonium_kernel_url::connectReplySignals(QNetworkReply *reply)
 	  this,
 	  SLOT(slotError(QNetworkReply::NetworkError)),
 	  Qt::UniqueConnection);
+  connect(reply,
+	  SIGNAL(metaDataChanged(void)),
+	  this,
+	  SLOT(slotMetaDataChanged(void)),
+	  Qt::UniqueConnection);
   connect(reply,
 	  SIGNAL(finished(void)),
 	  this,
@@ -103,177 +138,322 @@ void pandamonium_kernel_url::connectReplySignals(QNetworkReply *reply)
 	  Qt::UniqueConnection);
 }
 
-void pandamonium_kernel_url::parseContent(void)
+void pandamonium_kernel_url::consume
+(QNetworkReply *reply, pandamonium_kernel_url_fetch &state)
 {
   /*
-  ** Let's discover all links.
+  ** The content is decoded and parsed as it arrives. The bodies of
+  ** redirections are discarded.
   */
 
-  QString description("");
-  QString title("");
-  QStringList words;
-  bool metaDataOnly = pandamonium_database::isUrlMetaDataOnly(m_url);
-  int s = -1;
+  QByteArray bytes(reply->readAll());
 
-  if(metaDataOnly)
+  if(bytes.isEmpty() || !state.m_parser)
+    return;
+  else if(!reply->attribute(QNetworkRequest::RedirectionTargetAttribute).
+	  isNull())
+    return;
+
+  if(!state.m_decoder)
+    state.m_decoder = QSharedPointer<pandamonium_kernel_decoder>
+      (new pandamonium_kernel_decoder(reply->rawHeader("Content-Encoding")));
+
+  QByteArray decoded(state.m_decoder->decode(bytes));
+
+  pandamonium_kernel::recordHostStatistics
+    (reply->url().host(),
+     static_cast<quint64> (decoded.size()),
+     static_cast<quint64> (bytes.size()));
+
+  if(state.m_decoder->hasError())
     {
-      QString content("");
+      state.m_content.clear();
+      state.m_hash.clear();
+      state.m_parser.clear();
+      return;
+    }
 
-      s = m_content.toLower().indexOf("<meta");
+  state.m_decodedBytes += decoded.size();
 
-      while(s >= 0)
-	{
-	  QByteArray meta;
-	  int e = m_content.indexOf(">", s);
+  if(state.m_hash)
+    state.m_hash->addData(decoded);
 
-	  if(e >= s - 1)
-	    meta = m_content.mid(s, e - s + 1);
-	  else
-	    break;
+  if(!state.m_metaDataOnly)
+    state.m_content.append(decoded);
 
-	  QByteArray bytes(meta);
+  state.m_parser->feed(decoded);
+}
 
-	  bytes.replace(" ", "");
+void pandamonium_kernel_url::fetch
+(const QUrl &url,
+ const QUrl &urlToLoad,
+ const int depth,
+ const QPair<QByteArray, QByteArray> &validators)
+{
+  QNetworkRequest request(url);
+  pandamonium_kernel_url_fetch state(urlToLoad, depth, m_metaDataOnly);
 
-	  if(bytes.toLower().contains("name=\"description\"") ||
-	     bytes.toLower().contains("name=\"keywords\""))
-	    {
-	      int s = meta.toLower().indexOf("content");
+  /*
+  ** If only meta-data is saved, the heads of pages suffice. Links
+  ** which follow the heads are not discovered.
+  */
 
-	      if(s >= 0)
-		{
-		  int e = -1;
+  state.m_headOnly = m_headOnly && state.m_metaDataOnly;
 
-		  s = meta.indexOf("\"", s);
-		  e = meta.indexOf("\"", s + 1);
+  if(state.m_headOnly)
+    request.setRawHeader
+      ("Range", QString("bytes=0-%1").arg(s_maximumHeadSize - 1).toLatin1());
 
-		  if(e >= s)
-		    {
-		      content.append
-			(QString::fromUtf8(meta.mid(s + 1, e - s - 1).
-					   constData()));
-		      content.append(" ");
-		    }
-		}
-	    }
+  /*
+  ** Revisits are conditional. The validators accompany due URLs.
+  */
 
-	  s = m_content.toLower().indexOf("<meta", e);
-	}
+  if(!validators.first.isEmpty())
+    request.setRawHeader("If-None-Match", validators.first);
 
-      words = content.split(QRegExp("\\W+"), QString::SkipEmptyParts);
-    }
-  else
+  if(!validators.second.isEmpty())
+    request.setRawHeader("If-Modified-Since", validators.second);
+
+  QNetworkReply *reply = pandamonium_kernel::get(request);
+
+  reply->setParent(this);
+  connectReplySignals(reply);
+  m_fetches[reply] = state;
+  pandamonium_kernel::recordDepthStatistics(depth, 0, 1);
+}
+
+void pandamonium_kernel_url::load
+(const QUrl &url,
+ const int depth,
+ const QPair<QByteArray, QByteArray> &validators)
+{
+  if(url.isEmpty() || !url.isValid())
+    return;
+  else if(url.scheme().toLower().trimmed() != "http" &&
+	  url.scheme().toLower().trimmed() != "https")
     {
-      QTextDocument textDocument;
+      /*
+      ** The URL cannot be fetched. It is not read again.
+      */
 
-      textDocument.setHtml(m_content);
-      words = textDocument.toPlainText().
-	split(QRegExp("\\W+"), QString::SkipEmptyParts);
-      qSort(words.begin(), words.end(), sortStringListByLength);
+      pandamonium_kernel::markUrlAsVisited(url, true, depth);
+      return;
     }
 
-  while(!words.isEmpty())
-    if(!description.contains(words.first()))
-      {
-	description.append(words.takeFirst());
-	description.append(" ");
-      }
-    else
-      words.removeFirst();
+  /*
+  ** A URL which is being fetched is marked as visited by its fetch.
+  */
 
-  if((s = m_content.toLower().indexOf("<title>")) >= 0)
+  QHashIterator<QNetworkReply *, pandamonium_kernel_url_fetch> it(m_fetches);
+
+  while(it.hasNext())
     {
-      int e = m_content.toLower().indexOf("</title>");
+      it.next();
 
-      if(e >= s + 7)
-	title = QString::fromUtf8
-	  (m_content.mid(s + 7, e - s - 7).trimmed().constData());
+      if(it.value().m_urlToLoad == url)
+	return;
     }
 
-  pandamonium_database::saveUrlMetaData
-    (m_content, description, title, m_urlToLoad);
-  s = m_content.toLower().indexOf("<a");
+  fetch(url, url, depth, validators);
+}
+
+void pandamonium_kernel_url::parseContent
+(const pandamonium_kernel_url_fetch &state, const QUrl &baseUrl)
+{
+  /*
+  ** Let's discover all links.
+  */
+
+  QSet<QString> set;
+  QString title("");
+  QStringList unique;
+  QStringList words;
+  bool metaDataOnly = state.m_metaDataOnly;
+  int depth = state.m_depth;
+  pandamonium_kernel_parser *parser = state.m_parser.data();
 
-  while(s >= 0)
+  if(!parser)
+    return;
+
+  parser->finish();
+
+  if(metaDataOnly)
     {
-      QByteArray a;
-      int e = m_content.toLower().indexOf("</a>", s);
+      QString text("");
+
+      foreach(const QByteArray &bytes, parser->metaData())
+	{
+	  text.append(QString::fromUtf8(bytes.constData()));
+	  text.append(" ");
+	}
 
-      if(e >= s - 4)
-	a = m_content.mid(s, e - s + 4);
-      else
-	break;
+      words = text.split(QRegExp("\\W+"), QString::SkipEmptyParts);
+    }
+  else
+    words = parser->text().split(QRegExp("\\W+"), QString::SkipEmptyParts);
 
-      s = m_content.toLower().indexOf("<a", e);
+  /*
+  ** Distinct words, in order of appearance.
+  */
+
+  set.reserve(words.size());
 
+  for(int i = 0; i < words.size(); i++)
+    if(!set.contains(words.at(i)))
+      {
+	set.insert(words.at(i));
+	unique << words.at(i);
+      }
+
+  if(!metaDataOnly)
+    {
       /*
-      ** a = <a ...>...</a>
+      ** The longest words describe the page.
       */
 
-      if(a.toLower().contains("href"))
-	{
-	  QByteArray href;
-	  QUrl url;
-	  int e = -1;
-	  int s = a.toLower().indexOf("href");
-
-	  s = a.indexOf("\"", s);
-	  e = a.indexOf("\"", s + 1);
-	  href = a.mid(s + 1, e - s - 1);
-	  url = QUrl::fromEncoded(href);
-
-	  if(href.startsWith("/"))
-	    {
-	      url = m_url;
-	      url = url.resolved(QUrl::fromEncoded(href));
-	    }
-	  else if(href.startsWith("//"))
-	    url.setScheme(m_url.scheme());
-
-	  if(url.scheme() == "http" || url.scheme() == "https")
-	    pandamonium_database::markUrlAsVisited(url, false);
-	  else if(url.toString().startsWith(m_url.toString()))
-	    pandamonium_database::markUrlAsVisited(url, false);
-	}
+      int k = qMin
+	(unique.size(), static_cast<int> (s_maximumDescriptionWords));
+
+      std::partial_sort
+	(unique.begin(), unique.begin() + k, unique.end(),
+	 sortStringListByLength);
+
+      while(unique.size() > k)
+	unique.removeLast();
     }
 
-  m_content.clear();
+  /*
+  ** The content is not retained for meta-data-only search URLs.
+  */
+
+  title = QString::fromUtf8(parser->title().constData());
+  pandamonium_kernel::saveUrlMetaData
+    (metaDataOnly ? QByteArray("") : state.m_content,
+     state.m_hash ? state.m_hash->result().toHex() : QByteArray(),
+     state.m_etag,
+     state.m_lastModified,
+     unique.join(" "),
+     title,
+     state.m_urlToLoad);
+
+  /*
+  ** Links beyond the search depth are not expanded. A negative
+  ** search depth is infinite.
+  */
+
+  if(m_searchDepth >= 0 && depth >= m_searchDepth)
+    return;
+
+  QList<QUrl> urls;
+
+  /*
+  ** Links are relative to the fetched page. The page may belong to
+  ** another search URL's host.
+  */
+
+  foreach(const QByteArray &href, parser->links())
+    {
+      QUrl url(baseUrl.resolved(QUrl::fromEncoded(href)));
+
+      if(url.scheme() == "http" || url.scheme() == "https")
+	urls << url;
+    }
+
+  urls = pandamonium_kernel::canonicalize(urls);
+
+  for(int i = urls.size() - 1; i >= 0; i--)
+    if(pandamonium_kernel::isUrlDisallowed(urls.at(i)))
+      urls.removeAt(i);
+
+  pandamonium_kernel::markUrlsAsUnvisited(urls, depth + 1, m_seed);
+}
+
+void pandamonium_kernel_url::reject
+(QNetworkReply *reply, const QString &error)
+{
+  if(!reply || !m_fetches.contains(reply))
+    return;
+
+  pandamonium_kernel_url_fetch &state(m_fetches[reply]);
+
+  if(state.m_rejected)
+    return;
+
+  /*
+  ** The URL is marked as visited once the reply finishes. It will
+  ** not be queued again.
+  */
+
+  state.m_content.clear();
+  state.m_parser.clear();
+  state.m_rejected = true;
+  pandamonium_kernel::recordBrokenUrl(error, reply->url(), m_url);
+  reply->abort(); // May emit error() and finished() immediately.
+}
+
+void pandamonium_kernel_url::setConcurrency(const int concurrency)
+{
+  m_concurrency = qBound(1, concurrency, 16);
+}
+
+void pandamonium_kernel_url::setHeadOnly(const bool headOnly)
+{
+  m_headOnly = headOnly;
+}
+
+void pandamonium_kernel_url::setMetaDataOnly(const bool metaDataOnly)
+{
+  m_metaDataOnly = metaDataOnly;
 }
 
 void pandamonium_kernel_url::setPaused(const bool paused)
 {
   m_paused = paused;
-
-  if(m_paused)
-    m_loadNextTimer.stop();
-  else
-    {
-      if(!m_loadNextTimer.isActive())
-	m_loadNextTimer.start();
-    }
 }
 
 void pandamonium_kernel_url::setRequestInterval(const double request_interval)
 {
   m_requestInterval = qBound(0.100, request_interval, 100.00);
+}
 
-  if(m_loadNextTimer.interval() !=
-     static_cast<int> (1000 * m_requestInterval))
-    m_loadNextTimer.start(static_cast<int> (1000 * m_requestInterval));
+void pandamonium_kernel_url::setSearchDepth(const int search_depth)
+{
+  m_searchDepth = search_depth;
 }
 
 void pandamonium_kernel_url::slotAbortTimeout(void)
 {
-  if(!m_isLoaded)
-    {
-      m_content.clear();
+  /*
+  ** Fetches which have not progressed recently are abandoned. Fetches
+  ** which are receiving bytes are not limited.
+  */
 
-      QNetworkReply *reply = findChild<QNetworkReply *> ();
+  QDateTime now(QDateTime::currentDateTime());
+  QMutableHashIterator<QNetworkReply *, pandamonium_kernel_url_fetch>
+    it(m_fetches);
 
-      if(reply)
+  while(it.hasNext())
+    {
+      it.next();
+
+      if(it.value().m_lastProgress.msecsTo(now) >= s_inactivityTimeout)
 	{
+	  QNetworkReply *reply = it.key();
+	  pandamonium_kernel_url_fetch state(it.value());
+
 	  qDebug() << "Aborting " << reply->url() << "!";
+	  it.remove();
+
+	  /*
+	  ** The abortion emits error() and finished(). They are not
+	  ** delivered.
+	  */
+
+	  disconnect(reply, 0, this, 0);
+	  reply->abort();
 	  reply->deleteLater();
+	  pandamonium_kernel::requeueUrl
+	    (state.m_urlToLoad, state.m_depth, m_seed);
 	}
     }
 }
@@ -281,26 +461,76 @@ void pandamonium_kernel_url::slotAbortTimeout(void)
 void pandamonium_kernel_url::slotDownloadProgress
 (qint64 bytesReceived, qint64 bytesTotal)
 {
-  Q_UNUSED(bytesReceived);
   Q_UNUSED(bytesTotal);
 
   QNetworkReply *reply = qobject_cast<QNetworkReply *> (sender());
 
-  if(reply)
-    m_content.append(reply->readAll());
+  if(!reply || !m_fetches.contains(reply))
+    return;
+
+  if(bytesReceived > m_maximumContentLength)
+    {
+      /*
+      ** Chunked bodies do not announce their lengths.
+      */
+
+      reject
+	(reply,
+	 QString("The content exceeds %1 bytes.").arg(m_maximumContentLength));
+      return;
+    }
+
+  pandamonium_kernel_url_fetch &state(m_fetches[reply]);
+
+  consume(reply, state);
+  state.m_lastProgress = QDateTime::currentDateTime();
+
+  if(state.m_decoder && state.m_decoder->hasError())
+    {
+      reject(reply, "The content could not be decoded.");
+      return;
+    }
+  else if(state.m_decodedBytes > m_maximumContentLength)
+    {
+      reject
+	(reply,
+	 QString("The decoded content exceeds %1 bytes.").
+	 arg(m_maximumContentLength));
+      return;
+    }
+
+  if(state.m_headOnly && !state.m_headSeen && state.m_parser)
+    if(bytesReceived >= s_maximumHeadSize ||
+       state.m_parser->isHeadComplete())
+      {
+	/*
+	** Servers may ignore the range. The reply is aborted.
+	** The abortion may emit error() and finished() immediately.
+	*/
+
+	state.m_headSeen = true;
+	reply->abort();
+      }
 }
 
 void pandamonium_kernel_url::slotError(QNetworkReply::NetworkError code)
 {
-  m_abortTimer.stop();
-  m_content.clear();
-  m_isLoaded = true;
-
   QNetworkReply *reply = qobject_cast<QNetworkReply *> (sender());
 
   if(reply)
     {
-      pandamonium_database::recordBrokenUrl
+      if(m_fetches.value(reply).m_headSeen)
+	return; // Aborted after the head was parsed.
+      else if(m_fetches.value(reply).m_rejected)
+	return; // Recorded by reject().
+
+      if(m_fetches.contains(reply))
+	{
+	  m_fetches[reply].m_content.clear();
+	  m_fetches[reply].m_parser.clear();
+	}
+
+      pandamonium_kernel::recordBrokenUrl
 	(reply->errorString(), reply->url(), m_url);
       qDebug() << "Network error " << code << "!" << reply->url();
       reply->deleteLater();
@@ -309,80 +539,95 @@ void pandamonium_kernel_url::slotError(QNetworkReply::NetworkError code)
     qDebug() << "Network error " << code << "!";
 }
 
-void pandamonium_kernel_url::slotLoadNext(void)
+void pandamonium_kernel_url::slotMetaDataChanged(void)
 {
-  if(m_paused)
-    return;
+  QNetworkReply *reply = qobject_cast<QNetworkReply *> (sender());
 
-  if(!findChildren<QNetworkReply *> ().isEmpty())
+  if(!reply || !m_fetches.contains(reply))
+    return;
+  else if(!reply->attribute(QNetworkRequest::RedirectionTargetAttribute).
+	  isNull())
     return;
 
-  QUrl url(pandamonium_database::unvisitedChildUrl());
-
-  if(url.isEmpty() || !url.isValid())
-    url = m_url; // Restart.
-
-  if(!url.isEmpty())
-    if(url.isValid())
-      if(url.scheme().toLower().trimmed() == "http" ||
-	 url.scheme().toLower().trimmed() == "https")
-	{
-	  m_abortTimer.start();
-	  m_content.clear();
-	  m_isLoaded = false;
-	  m_urlToLoad = url;
-
-	  QNetworkReply *reply =
-	    pandamonium_kernel::get(QNetworkRequest(m_urlToLoad));
-
-	  reply->setParent(this);
-	  connectReplySignals(reply);
-	}
+  QString type
+    (reply->header(QNetworkRequest::ContentTypeHeader).toString().
+     section(';', 0, 0).trimmed().toLower());
+  qint64 length = reply->header(QNetworkRequest::ContentLengthHeader).
+    toLongLong();
+
+  if(!type.isEmpty() &&
+     type != "application/xhtml+xml" &&
+     type != "text/html")
+    reject(reply, QString("The content type %1 is not HTML.").arg(type));
+  else if(length > m_maximumContentLength)
+    reject(reply,
+	   QString("The content length %1 exceeds %2 bytes.").
+	   arg(length).arg(m_maximumContentLength));
 }
 
 void pandamonium_kernel_url::slotReplyFinished(void)
 {
-  m_abortTimer.stop();
-  m_isLoaded = true;
-  pandamonium_database::markUrlAsVisited(m_urlToLoad, true);
-
   QNetworkReply *reply = qobject_cast<QNetworkReply *> (sender());
-  QNetworkReply::NetworkError code = QNetworkReply::NoError;
-  bool redirect = false;
 
-  if(reply)
+  if(!reply || !m_fetches.contains(reply))
     {
-      code = reply->error();
+      // We'll consider this an error.
 
-      QUrl redirectUrl
-	(reply->attribute(QNetworkRequest::RedirectionTargetAttribute).
-	 toUrl());
+      if(reply)
+	reply->deleteLater();
 
-      if(!reply->attribute(QNetworkRequest::RedirectionTargetAttribute).
-	 isNull())
-	if(redirectUrl.isRelative())
-	  redirectUrl = m_url.resolved(redirectUrl);
+      return;
+    }
 
-      reply->deleteLater();
+  pandamonium_kernel_url_fetch state(m_fetches.take(reply));
 
-      if(!redirectUrl.isEmpty())
-	if(redirectUrl.isValid())
-	  {
-	    redirect = true;
-	    reply = pandamonium_kernel::get(QNetworkRequest(redirectUrl));
-	    reply->setParent(this);
-	    connectReplySignals(reply);
-	  }
-    }
-  else
+  pandamonium_kernel::markUrlAsVisited(state.m_urlToLoad, true, state.m_depth);
+
+  QNetworkReply::NetworkError code = reply->error();
+  QUrl redirectUrl
+    (reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl());
+
+  if(!reply->attribute(QNetworkRequest::RedirectionTargetAttribute).isNull())
+    if(redirectUrl.isRelative())
+      redirectUrl = reply->url().resolved(redirectUrl);
+
+  consume(reply, state);
+  reply->deleteLater();
+
+  if(code == QNetworkReply::NoError &&
+     reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
     {
-      // We'll consider this an error.
+      /*
+      ** The content has not changed since it was parsed.
+      */
 
+      pandamonium_kernel::markUrlAsValidated(state.m_urlToLoad);
       return;
     }
 
-  if(code == QNetworkReply::NoError && !redirect)
-    parseContent();
+  state.m_etag = reply->rawHeader("ETag");
+  state.m_lastModified = reply->rawHeader("Last-Modified");
+
+  if(!redirectUrl.isEmpty())
+    if(redirectUrl.isValid())
+      {
+	fetch(redirectUrl,
+	      state.m_urlToLoad,
+	      state.m_depth,
+	      QPair<QByteArray, QByteArray> ());
+	return;
+      }
+
+  /*
+  ** The hashes of partial bodies do not describe the content.
+  */
+
+  if(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).
+     toInt() == 206 || state.m_headSeen || state.m_rejected)
+    state.m_hash.clear();
+
+  if(code == QNetworkReply::NoError || state.m_headSeen)
+    parseContent(state, reply->url());
 }
 
 void pandamonium_kernel_url::slotSslErrors(const QList<QSslError> &errors)
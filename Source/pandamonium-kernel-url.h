@@ -28,14 +28,70 @@
 #ifndef _pandamonium_kernel_url_h_
 #define _pandamonium_kernel_url_h_
 
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHash>
 #include <QObject>
 #include <QNetworkReply>
+#include <QPair>
+#include <QSharedPointer>
 #include <QSslError>
 #include <QTimer>
 #include <QUrl>
 
+#include "pandamonium-kernel-decoder.h"
+#include "pandamonium-kernel-parser.h"
+
 class QNetworkReply;
 
+class pandamonium_kernel_url_fetch
+{
+ public:
+  pandamonium_kernel_url_fetch(void)
+  {
+    m_decodedBytes = 0;
+    m_depth = 0;
+    m_headOnly = false;
+    m_headSeen = false;
+    m_metaDataOnly = true;
+    m_rejected = false;
+  }
+
+  pandamonium_kernel_url_fetch(const QUrl &urlToLoad,
+			       const int depth,
+			       const bool metaDataOnly)
+  {
+    m_decodedBytes = 0;
+    m_depth = depth;
+    m_headOnly = false;
+    m_hash = QSharedPointer<QCryptographicHash>
+      (new QCryptographicHash(QCryptographicHash::Sha1));
+    m_headSeen = false;
+    m_metaDataOnly = metaDataOnly;
+    m_rejected = false;
+    m_parser = QSharedPointer<pandamonium_kernel_parser>
+      (new pandamonium_kernel_parser());
+    m_parser->setExtractText(!metaDataOnly);
+    m_lastProgress = QDateTime::currentDateTime();
+    m_urlToLoad = urlToLoad;
+  }
+
+  QByteArray m_content; // Retained if all site words are saved.
+  QByteArray m_etag;
+  QByteArray m_lastModified;
+  QDateTime m_lastProgress; // The reply's most recent bytes.
+  QSharedPointer<QCryptographicHash> m_hash;
+  QSharedPointer<pandamonium_kernel_decoder> m_decoder;
+  QSharedPointer<pandamonium_kernel_parser> m_parser;
+  QUrl m_urlToLoad;
+  bool m_headOnly;
+  bool m_headSeen; // The reply was aborted after the head.
+  bool m_metaDataOnly;
+  bool m_rejected; // The reply was aborted because of its type or size.
+  int m_depth;
+  qint64 m_decodedBytes;
+};
+
 class pandamonium_kernel_url: public QObject
 {
   Q_OBJECT
@@ -44,30 +100,56 @@ class pandamonium_kernel_url: public QObject
   pandamonium_kernel_url(const QUrl &url,
 			 const bool paused,
 			 const double request_interval,
+			 const int concurrency,
 			 const int search_depth,
 			 QObject *parent);
   ~pandamonium_kernel_url();
+  QUrl url(void) const;
+  bool hasCapacity(void) const;
+  bool isIdle(void) const;
+  double requestInterval(void) const;
+  int searchDepth(void) const;
+  qint64 seed(void) const;
+  void load(const QUrl &url,
+	    const int depth,
+	    const QPair<QByteArray, QByteArray> &validators);
+  void setConcurrency(const int concurrency);
+  void setHeadOnly(const bool headOnly);
+  void setMetaDataOnly(const bool metaDataOnly);
   void setPaused(const bool paused);
   void setRequestInterval(const double request_interval);
+  void setSearchDepth(const int search_depth);
 
  private:
-  QByteArray m_content;
+  QHash<QNetworkReply *, pandamonium_kernel_url_fetch> m_fetches;
   QTimer m_abortTimer;
-  QTimer m_loadNextTimer;
   QUrl m_url;
-  QUrl m_urlToLoad;
-  bool m_isLoaded;
+  bool m_headOnly;
+  bool m_metaDataOnly;
   bool m_paused;
   double m_requestInterval;
+  int m_concurrency;
   int m_searchDepth;
+  qint64 m_maximumContentLength;
+  qint64 m_seed;
+  static const int s_inactivityTimeout = 10000; // Milliseconds.
+  static const int s_maximumDescriptionWords = 512;
+  static const int s_maximumHeadSize = 65536;
   void connectReplySignals(QNetworkReply *reply);
-  void parseContent(void);
+  void consume(QNetworkReply *reply, pandamonium_kernel_url_fetch &state);
+  void fetch(const QUrl &url,
+	     const QUrl &urlToLoad,
+	     const int depth,
+	     const QPair<QByteArray, QByteArray> &validators);
+  void parseContent(const pandamonium_kernel_url_fetch &state,
+		    const QUrl &baseUrl);
+  void reject(QNetworkReply *reply, const QString &error);
 
  private slots:
   void slotAbortTimeout(void);
   void slotDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
   void slotError(QNetworkReply::NetworkError code);
-  void slotLoadNext(void);
+  void slotMetaDataChanged(void);
   void slotReplyFinished(void);
   void slotSslErrors(const QList<QSslError> &errors);
 };
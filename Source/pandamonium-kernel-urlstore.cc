@@ -0,0 +1,800 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QDir>
+#include <QSet>
+#include <QtDebug>
+#include <QtEndian>
+#if QT_VERSION >= 0x050100
+#include <QSaveFile>
+#endif
+
+#include <algorithm>
+
+#include "pandamonium-common.h"
+#include "pandamonium-kernel-urlstore.h"
+
+#if QT_VERSION < 0x050100
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC) || defined(Q_OS_UNIX)
+extern "C"
+{
+#include <unistd.h>
+}
+#endif
+#endif
+
+static bool segmentGreaterThan(const pandamonium_kernel_urlstore_segment *s1,
+			       const pandamonium_kernel_urlstore_segment *s2)
+{
+  return s1->size() > s2->size();
+}
+
+static void appendBigEndian(QByteArray &bytes, const quint64 value)
+{
+  uchar b[8];
+
+  qToBigEndian<quint64>(value, b);
+  bytes.append(reinterpret_cast<const char *> (b), 8);
+}
+
+static void appendBigEndian(QByteArray &bytes, const quint32 value)
+{
+  uchar b[4];
+
+  qToBigEndian<quint32>(value, b);
+  bytes.append(reinterpret_cast<const char *> (b), 4);
+}
+
+pandamonium_kernel_urlstore_segment::pandamonium_kernel_urlstore_segment
+(void)
+{
+  m_blocks = 0;
+  m_count = 0;
+  m_data = 0;
+  m_indexOffset = 0;
+  m_length = 0;
+}
+
+pandamonium_kernel_urlstore_segment::~pandamonium_kernel_urlstore_segment()
+{
+  close();
+}
+
+QByteArray pandamonium_kernel_urlstore_segment::host(const quint32 id) const
+{
+  return m_hosts.value(static_cast<int> (id));
+}
+
+QList<QByteArray> pandamonium_kernel_urlstore_segment::hosts(void) const
+{
+  return m_hosts;
+}
+
+QPair<QByteArray, QByteArray> pandamonium_kernel_urlstore_segment::split
+(const QByteArray &url)
+{
+  QPair<QByteArray, QByteArray> pair;
+  int index = url.indexOf("://");
+
+  if(index <= 0)
+    return pair;
+
+  int i = index + 3;
+
+  while(i < url.length() &&
+	url.at(i) != '#' && url.at(i) != '/' && url.at(i) != '?')
+    i += 1;
+
+  pair.first = url.mid(0, i);
+  pair.second = url.mid(i);
+  return pair;
+}
+
+QString pandamonium_kernel_urlstore_segment::fileName(void) const
+{
+  return m_file.fileName();
+}
+
+bool pandamonium_kernel_urlstore_segment::decode(quint64 &offset,
+						 quint32 &host,
+						 QByteArray &path,
+						 int &depth) const
+{
+  /*
+  ** path holds the path of the previous entry.
+  */
+
+  quint64 d = 0;
+  quint64 h = 0;
+  quint64 length = 0;
+  quint64 shared = 0;
+
+  if(!readVarint(offset, h) ||
+     !readVarint(offset, shared) ||
+     !readVarint(offset, length))
+    return false;
+
+  if(shared > static_cast<quint64> (path.length()) ||
+     length > static_cast<quint64> (m_length) - offset)
+    return false;
+
+  path.truncate(static_cast<int> (shared));
+  path.append
+    (reinterpret_cast<const char *> (m_data + offset),
+     static_cast<int> (length));
+  offset += length;
+
+  if(!readVarint(offset, d))
+    return false;
+
+  depth = static_cast<int> (d);
+  host = static_cast<quint32> (h);
+  return true;
+}
+
+bool pandamonium_kernel_urlstore_segment::next
+(pandamonium_kernel_urlstore_cursor &cursor, QByteArray &url, int &depth) const
+{
+  if(!m_data || cursor.m_index >= m_count)
+    return false;
+
+  if(cursor.m_index == 0)
+    cursor.m_offset = s_headerSize;
+
+  if(!decode(cursor.m_offset, cursor.m_host, cursor.m_path, depth) ||
+     cursor.m_host >= static_cast<quint32> (m_hosts.size()))
+    return false;
+
+  cursor.m_index += 1;
+  url = m_hosts.at(static_cast<int> (cursor.m_host)) + cursor.m_path;
+  return true;
+}
+
+bool pandamonium_kernel_urlstore_segment::open(const QString &fileName)
+{
+  close();
+  m_file.setFileName(fileName);
+
+  if(!m_file.open(QIODevice::ReadOnly) || m_file.size() < s_headerSize)
+    {
+      qDebug() << "Cannot open " << m_file.fileName() << "!";
+      close();
+      return false;
+    }
+
+  m_data = m_file.map(0, m_file.size());
+
+  if(!m_data)
+    {
+      qDebug() << "Cannot map " << m_file.fileName() << "!";
+      close();
+      return false;
+    }
+
+  m_length = m_file.size();
+
+  quint64 hostsOffset = qFromBigEndian<quint64> (m_data + 24);
+  quint64 length = static_cast<quint64> (m_length);
+
+  m_blocks = qFromBigEndian<quint64> (m_data + 16);
+  m_count = qFromBigEndian<quint64> (m_data + 8);
+  m_indexOffset = qFromBigEndian<quint64> (m_data + 32);
+
+  if(qFromBigEndian<quint32> (m_data) != s_magic ||
+     qFromBigEndian<quint32> (m_data + 4) != s_blockSize ||
+     hostsOffset > m_indexOffset ||
+     m_indexOffset > length ||
+     (length - m_indexOffset) / 8 != m_blocks ||
+     m_blocks != (m_count + s_blockSize - 1) / s_blockSize)
+    {
+      qDebug() << m_file.fileName() << " is corrupt!";
+      close();
+      return false;
+    }
+
+  quint64 count = 0;
+  quint64 offset = hostsOffset;
+
+  if(!readVarint(offset, count))
+    {
+      close();
+      return false;
+    }
+
+  for(quint64 i = 0; i < count; i++)
+    {
+      quint64 size = 0;
+
+      if(!readVarint(offset, size) || size > m_indexOffset - offset)
+	{
+	  qDebug() << m_file.fileName() << " is corrupt!";
+	  close();
+	  return false;
+	}
+
+      QByteArray host(reinterpret_cast<const char *> (m_data + offset),
+		      static_cast<int> (size));
+
+      m_hostIds[host] = static_cast<quint32> (m_hosts.size());
+      m_hosts << host;
+      offset += size;
+    }
+
+  return true;
+}
+
+bool pandamonium_kernel_urlstore_segment::readVarint
+(quint64 &offset, quint64 &value) const
+{
+  int shift = 0;
+
+  value = 0;
+
+  while(offset < static_cast<quint64> (m_length) && shift < 64)
+    {
+      uchar c = m_data[offset++];
+
+      value |= static_cast<quint64> (c & 0x7f) << shift;
+
+      if(!(c & 0x80))
+	return true;
+
+      shift += 7;
+    }
+
+  return false;
+}
+
+bool pandamonium_kernel_urlstore_segment::write
+(const QString &fileName,
+ const QList<const pandamonium_kernel_urlstore_segment *> &segments,
+ const QList<pandamonium_urlstore_entry> &list)
+{
+  /*
+  ** The entries of the segments and the sorted entries of list are
+  ** merged into a new segment. The shallowest depth of a URL is kept.
+  */
+
+  QSet<QByteArray> set;
+
+  for(int i = 0; i < segments.size(); i++)
+    foreach(const QByteArray &host, segments.at(i)->hosts())
+      set.insert(host);
+
+  for(int i = 0; i < list.size(); i++)
+    set.insert(list.at(i).first.first);
+
+  QHash<QByteArray, quint32> hostIds;
+  QList<QByteArray> hosts(set.values());
+
+  std::sort(hosts.begin(), hosts.end());
+
+  for(int i = 0; i < hosts.size(); i++)
+    hostIds[hosts.at(i)] = static_cast<quint32> (i);
+
+#if QT_VERSION >= 0x050100
+  QSaveFile file(fileName);
+
+  if(!file.open(QIODevice::WriteOnly))
+#else
+  QFile file(fileName + ".tmp");
+
+  if(!file.open(QIODevice::Truncate | QIODevice::WriteOnly))
+#endif
+    {
+      qDebug() << "Cannot open " << file.fileName() << "!";
+      return false;
+    }
+
+  QByteArray buffer(s_headerSize, 0);
+  QByteArray index;
+  QByteArray previous;
+  QList<bool> available;
+  QList<int> depths;
+  QList<pandamonium_kernel_urlstore_cursor> cursors;
+  bool ok = true;
+  int i = 0;
+  quint32 previousHost = 0;
+  quint64 count = 0;
+  quint64 written = 0;
+
+  for(int j = 0; j < segments.size(); j++)
+    {
+      QByteArray url;
+      int depth = 0;
+
+      cursors << pandamonium_kernel_urlstore_cursor();
+      available << segments.at(j)->next(cursors[j], url, depth);
+      depths << depth;
+    }
+
+  while(ok)
+    {
+      QPair<QByteArray, QByteArray> key;
+      bool found = false;
+      int depth = 0;
+
+      for(int j = 0; j < segments.size(); j++)
+	if(available.at(j))
+	  {
+	    QPair<QByteArray, QByteArray> pair
+	      (segments.at(j)->host(cursors.at(j).m_host),
+	       cursors.at(j).m_path);
+
+	    if(!found || pair < key)
+	      {
+		depth = depths.at(j);
+		found = true;
+		key = pair;
+	      }
+	    else if(pair == key)
+	      depth = qMin(depth, depths.at(j));
+	  }
+
+      if(i < list.size())
+	{
+	  if(!found || list.at(i).first < key)
+	    {
+	      depth = list.at(i).second;
+	      found = true;
+	      key = list.at(i).first;
+	    }
+	}
+
+      if(!found)
+	break;
+
+      for(int j = 0; j < segments.size(); j++)
+	if(available.at(j) &&
+	   segments.at(j)->host(cursors.at(j).m_host) == key.first &&
+	   cursors.at(j).m_path == key.second)
+	  {
+	    QByteArray url;
+
+	    available[j] = segments.at(j)->next(cursors[j], url, depths[j]);
+	  }
+
+      while(i < list.size() && list.at(i).first == key)
+	{
+	  depth = qMin(depth, list.at(i).second);
+	  i += 1;
+	}
+
+      quint32 host = hostIds.value(key.first);
+      quint64 shared = 0;
+
+      if(count % s_blockSize == 0)
+	appendBigEndian(index, written + static_cast<quint64> (buffer.size()));
+      else if(host == previousHost)
+	{
+	  int length = qMin(previous.length(), key.second.length());
+
+	  while(static_cast<int> (shared) < length &&
+		previous.at(static_cast<int> (shared)) ==
+		key.second.at(static_cast<int> (shared)))
+	    shared += 1;
+	}
+
+      writeVarint(buffer, host);
+      writeVarint(buffer, shared);
+      writeVarint
+	(buffer, static_cast<quint64> (key.second.length()) - shared);
+      buffer.append(key.second.mid(static_cast<int> (shared)));
+      writeVarint(buffer, static_cast<quint64> (qMax(0, depth)));
+      count += 1;
+      previous = key.second;
+      previousHost = host;
+
+      if(buffer.size() >= 1048576)
+	{
+	  ok = file.write(buffer) == buffer.size();
+	  written += static_cast<quint64> (buffer.size());
+	  buffer.clear();
+	}
+    }
+
+  quint64 hostsOffset = written + static_cast<quint64> (buffer.size());
+
+  writeVarint(buffer, static_cast<quint64> (hosts.size()));
+
+  for(int j = 0; j < hosts.size(); j++)
+    {
+      writeVarint(buffer, static_cast<quint64> (hosts.at(j).length()));
+      buffer.append(hosts.at(j));
+    }
+
+  quint64 indexOffset = written + static_cast<quint64> (buffer.size());
+  QByteArray header;
+
+  appendBigEndian(header, s_magic);
+  appendBigEndian(header, s_blockSize);
+  appendBigEndian(header, count);
+  appendBigEndian(header, static_cast<quint64> (index.size() / 8));
+  appendBigEndian(header, hostsOffset);
+  appendBigEndian(header, indexOffset);
+
+  if(written == 0)
+    buffer.replace(0, s_headerSize, header);
+
+  buffer.append(index);
+
+  if(ok)
+    ok = file.write(buffer) == buffer.size();
+
+  if(ok && written > 0)
+    ok = file.seek(0) && file.write(header) == header.size();
+
+  /*
+  ** The segment is synchronized before it is renamed.
+  */
+
+#if QT_VERSION >= 0x050100
+  if(!ok)
+    file.cancelWriting();
+
+  ok = file.commit() && ok;
+#else
+  ok = ok && file.flush();
+#if defined(Q_OS_LINUX) || defined(Q_OS_MAC) || defined(Q_OS_UNIX)
+  ok = ok && fsync(file.handle()) == 0;
+#endif
+  file.close();
+  ok = ok && QFile::rename(file.fileName(), fileName);
+
+  if(!ok)
+    file.remove();
+#endif
+
+  if(!ok)
+    qDebug() << "Cannot write " << fileName << "!";
+
+  return ok;
+}
+
+int pandamonium_kernel_urlstore_segment::depth(const QByteArray &url) const
+{
+  if(!m_data || m_blocks == 0)
+    return -1;
+
+  QPair<QByteArray, QByteArray> key(split(url));
+
+  if(!m_hostIds.contains(key.first))
+    return -1;
+
+  QByteArray path;
+  int depth = 0;
+  quint32 h = 0;
+  quint32 host = m_hostIds.value(key.first);
+  quint64 high = m_blocks;
+  quint64 low = 0;
+
+  /*
+  ** The last block whose first entry does not exceed the key.
+  */
+
+  while(low < high)
+    {
+      quint64 middle = low + (high - low) / 2;
+      quint64 offset = qFromBigEndian<quint64>
+	(m_data + m_indexOffset + 8 * middle);
+
+      path.clear();
+
+      if(!decode(offset, h, path, depth))
+	return -1;
+
+      if(h < host || (h == host && !(key.second < path)))
+	low = middle + 1;
+      else
+	high = middle;
+    }
+
+  if(low == 0)
+    return -1;
+
+  quint64 block = low - 1;
+  quint64 offset = qFromBigEndian<quint64>
+    (m_data + m_indexOffset + 8 * block);
+
+  path.clear();
+
+  for(quint64 i = block * s_blockSize;
+      i < qMin(m_count, (block + 1) * s_blockSize);
+      i++)
+    {
+      if(!decode(offset, h, path, depth))
+	return -1;
+
+      if(h == host && path == key.second)
+	return depth;
+      else if(h > host || (h == host && key.second < path))
+	return -1;
+    }
+
+  return -1;
+}
+
+qint64 pandamonium_kernel_urlstore_segment::bytes(void) const
+{
+  return m_length;
+}
+
+quint64 pandamonium_kernel_urlstore_segment::size(void) const
+{
+  return m_count;
+}
+
+void pandamonium_kernel_urlstore_segment::close(void)
+{
+  if(m_data)
+    m_file.unmap(const_cast<uchar *> (m_data));
+
+  m_blocks = 0;
+  m_count = 0;
+  m_data = 0;
+  m_file.close();
+  m_hostIds.clear();
+  m_hosts.clear();
+  m_indexOffset = 0;
+  m_length = 0;
+}
+
+void pandamonium_kernel_urlstore_segment::writeVarint
+(QByteArray &bytes, quint64 value)
+{
+  while(value >= 0x80)
+    {
+      bytes.append(static_cast<char> ((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+
+  bytes.append(static_cast<char> (value));
+}
+
+pandamonium_kernel_urlstore::pandamonium_kernel_urlstore(void)
+{
+  m_sequence = 0;
+}
+
+pandamonium_kernel_urlstore::~pandamonium_kernel_urlstore()
+{
+  close();
+}
+
+QString pandamonium_kernel_urlstore::fileName(const quint64 sequence)
+{
+  return pandamonium_common::homePath() + QDir::separator() +
+    QString("pandamonium_visited_urls.store.%1").arg(sequence);
+}
+
+bool pandamonium_kernel_urlstore::contains(const QByteArray &url) const
+{
+  return depth(url) >= 0;
+}
+
+bool pandamonium_kernel_urlstore::merge
+(const QList<QPair<QByteArray, int> > &urls)
+{
+  QList<pandamonium_urlstore_entry> list;
+
+  for(int i = 0; i < urls.size(); i++)
+    {
+      QPair<QByteArray, QByteArray> pair
+	(pandamonium_kernel_urlstore_segment::split(urls.at(i).first));
+
+      if(pair.first.isEmpty())
+	continue;
+
+      list << pandamonium_urlstore_entry(pair, qMax(0, urls.at(i).second));
+    }
+
+  if(list.isEmpty())
+    return true;
+
+  std::sort(list.begin(), list.end());
+
+  QString name(fileName(m_sequence));
+
+  if(!pandamonium_kernel_urlstore_segment::write
+     (name, QList<const pandamonium_kernel_urlstore_segment *> (), list))
+    return false;
+
+  m_sequence += 1;
+
+  pandamonium_kernel_urlstore_segment *segment =
+    new pandamonium_kernel_urlstore_segment();
+
+  if(!segment->open(name))
+    {
+      delete segment;
+      QFile::remove(name);
+      return false;
+    }
+
+  m_segments << segment;
+  compact();
+  return true;
+}
+
+bool pandamonium_kernel_urlstore::next
+(pandamonium_kernel_urlstore_cursor &cursor, QByteArray &url, int &depth) const
+{
+  while(cursor.m_segment >= 0 && cursor.m_segment < m_segments.size())
+    {
+      if(m_segments.at(cursor.m_segment)->next(cursor, url, depth))
+	return true;
+
+      cursor.m_host = 0;
+      cursor.m_index = 0;
+      cursor.m_offset = 0;
+      cursor.m_path.clear();
+      cursor.m_segment += 1;
+    }
+
+  return false;
+}
+
+int pandamonium_kernel_urlstore::depth(const QByteArray &url) const
+{
+  int depth = -1;
+
+  for(int i = 0; i < m_segments.size(); i++)
+    {
+      int d = m_segments.at(i)->depth(url);
+
+      if(d >= 0 && (depth < 0 || d < depth))
+	depth = d;
+    }
+
+  return depth;
+}
+
+qint64 pandamonium_kernel_urlstore::bytes(void) const
+{
+  qint64 bytes = 0;
+
+  for(int i = 0; i < m_segments.size(); i++)
+    bytes += m_segments.at(i)->bytes();
+
+  return bytes;
+}
+
+quint64 pandamonium_kernel_urlstore::size(void) const
+{
+  quint64 size = 0;
+
+  for(int i = 0; i < m_segments.size(); i++)
+    size += m_segments.at(i)->size();
+
+  return size;
+}
+
+void pandamonium_kernel_urlstore::close(void)
+{
+  while(!m_segments.isEmpty())
+    delete m_segments.takeFirst();
+
+  m_sequence = 0;
+}
+
+void pandamonium_kernel_urlstore::compact(void)
+{
+  /*
+  ** An interruption between the rename of a merged segment and the
+  ** removal of its sources leaves duplicate entries. They are
+  ** discarded by a later merge.
+  */
+
+  while(m_segments.size() >= 2)
+    {
+      sort();
+
+      pandamonium_kernel_urlstore_segment *larger =
+	m_segments.at(m_segments.size() - 2);
+      pandamonium_kernel_urlstore_segment *smaller = m_segments.last();
+
+      if(m_segments.size() <= s_maximumSegments &&
+	 2 * smaller->size() < larger->size())
+	break;
+
+      QList<const pandamonium_kernel_urlstore_segment *> segments;
+      QString name(fileName(m_sequence));
+
+      segments << larger << smaller;
+
+      if(!pandamonium_kernel_urlstore_segment::write
+	 (name, segments, QList<pandamonium_urlstore_entry> ()))
+	break;
+
+      m_sequence += 1;
+
+      pandamonium_kernel_urlstore_segment *segment =
+	new pandamonium_kernel_urlstore_segment();
+
+      if(!segment->open(name))
+	{
+	  delete segment;
+	  QFile::remove(name);
+	  break;
+	}
+
+      QStringList fileNames;
+
+      fileNames << larger->fileName() << smaller->fileName();
+      m_segments.removeAll(larger);
+      m_segments.removeAll(smaller);
+      delete larger;
+      delete smaller;
+      m_segments << segment;
+
+      foreach(const QString &string, fileNames)
+	QFile::remove(string);
+    }
+}
+
+void pandamonium_kernel_urlstore::open(void)
+{
+  /*
+  ** Temporary files are not segments.
+  */
+
+  close();
+
+  QDir dir(pandamonium_common::homePath());
+  QString prefix("pandamonium_visited_urls.store.");
+
+  foreach(const QString &name,
+	  dir.entryList(QStringList() << prefix + "*", QDir::Files))
+    {
+      bool ok = true;
+      quint64 sequence = name.mid(prefix.length()).toULongLong(&ok);
+
+      if(!ok)
+	continue;
+
+      m_sequence = qMax(m_sequence, sequence + 1);
+
+      pandamonium_kernel_urlstore_segment *segment =
+	new pandamonium_kernel_urlstore_segment();
+
+      if(segment->open(dir.absoluteFilePath(name)))
+	m_segments << segment;
+      else
+	delete segment;
+    }
+
+  sort();
+}
+
+void pandamonium_kernel_urlstore::sort(void)
+{
+  /*
+  ** The largest segment first.
+  */
+
+  std::stable_sort(m_segments.begin(), m_segments.end(), segmentGreaterThan);
+}
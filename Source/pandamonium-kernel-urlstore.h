@@ -0,0 +1,150 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_urlstore_h_
+#define _pandamonium_kernel_urlstore_h_
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPair>
+
+typedef QPair<QPair<QByteArray, QByteArray>, int> pandamonium_urlstore_entry;
+
+class pandamonium_kernel_urlstore_cursor
+{
+ public:
+  pandamonium_kernel_urlstore_cursor(void)
+  {
+    m_host = 0;
+    m_index = 0;
+    m_offset = 0;
+    m_segment = 0;
+  }
+
+  QByteArray m_path;
+  int m_segment;
+  quint32 m_host;
+  quint64 m_index;
+  quint64 m_offset;
+};
+
+/*
+** A sorted, memory-mapped, immutable file of visited URLs. URLs are
+** split into origins (scheme://authority) and paths. Origins are
+** interned in a sorted host table. Entries, ordered by origin and path,
+** are grouped into blocks of s_blockSize entries. The path of an entry
+** is stored as the length of the prefix which it shares with the path
+** of the previous entry of the same host and the remaining suffix. The
+** first entry of a block is stored whole, so a lookup is a binary
+** search of the block index followed by a scan of one block. Entries
+** also carry their depths.
+**
+** Layout: header, blocks, host table, block index. Integers within
+** entries and the host table are varints; header and index fields are
+** big-endian.
+*/
+
+class pandamonium_kernel_urlstore_segment
+{
+ public:
+  pandamonium_kernel_urlstore_segment(void);
+  ~pandamonium_kernel_urlstore_segment();
+  QByteArray host(const quint32 id) const;
+  QList<QByteArray> hosts(void) const;
+  QString fileName(void) const;
+  bool next(pandamonium_kernel_urlstore_cursor &cursor,
+	    QByteArray &url,
+	    int &depth) const;
+  bool open(const QString &fileName);
+  int depth(const QByteArray &url) const;
+  qint64 bytes(void) const;
+  quint64 size(void) const;
+  static QPair<QByteArray, QByteArray> split(const QByteArray &url);
+  static bool write
+    (const QString &fileName,
+     const QList<const pandamonium_kernel_urlstore_segment *> &segments,
+     const QList<pandamonium_urlstore_entry> &list);
+  void close(void);
+
+ private:
+  QFile m_file;
+  QHash<QByteArray, quint32> m_hostIds;
+  QList<QByteArray> m_hosts;
+  const uchar *m_data;
+  qint64 m_length;
+  quint64 m_blocks;
+  quint64 m_count;
+  quint64 m_indexOffset;
+  static const int s_headerSize = 40;
+  static const quint32 s_blockSize = 16;
+  static const quint32 s_magic = 0x50555331; // PUS1.
+  static void writeVarint(QByteArray &bytes, quint64 value);
+  bool decode(quint64 &offset,
+	      quint32 &host,
+	      QByteArray &path,
+	      int &depth) const;
+  bool readVarint(quint64 &offset, quint64 &value) const;
+};
+
+/*
+** The URL store. A merge writes its URLs into a new segment. Segments
+** are never modified. The two smallest segments are merged into a new
+** segment while the smaller holds at least half as many URLs as the
+** larger, so a URL is rewritten a logarithmic number of times. A
+** segment is written into a temporary file which is synchronized and
+** then renamed. Merged segments are removed after their replacement
+** has been renamed. A lookup consults every segment.
+*/
+
+class pandamonium_kernel_urlstore
+{
+ public:
+  pandamonium_kernel_urlstore(void);
+  ~pandamonium_kernel_urlstore();
+  bool contains(const QByteArray &url) const;
+  bool merge(const QList<QPair<QByteArray, int> > &urls);
+  bool next(pandamonium_kernel_urlstore_cursor &cursor,
+	    QByteArray &url,
+	    int &depth) const;
+  int depth(const QByteArray &url) const;
+  qint64 bytes(void) const;
+  quint64 size(void) const;
+  void close(void);
+  void open(void);
+
+ private:
+  QList<pandamonium_kernel_urlstore_segment *> m_segments;
+  quint64 m_sequence;
+  static const int s_maximumSegments = 16;
+  static QString fileName(const quint64 sequence);
+  void compact(void);
+  void sort(void);
+};
+
+#endif
@@ -0,0 +1,509 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <QElapsedTimer>
+#include <QSettings>
+
+#include "pandamonium-common.h"
+#include "pandamonium-database.h"
+#include "pandamonium-kernel-writer.h"
+
+pandamonium_kernel_writer::pandamonium_kernel_writer(void):QThread()
+{
+  QSettings settings;
+
+  m_batchSize = qBound
+    (1, settings.value("pandamonium_writer_batch_size", 1000).toInt(), 100000);
+  m_capacity = qBound
+    (m_batchSize,
+     settings.value("pandamonium_writer_capacity", 10000).toInt(),
+     1000000);
+  m_checkpoint = false;
+  m_compactionBatch = qBound
+    (1024,
+     settings.value("pandamonium_url_store_batch", 65536).toInt(),
+     1048576);
+  m_done = false;
+  m_interval = qBound
+    (10, settings.value("pandamonium_writer_interval", 500).toInt(), 60000);
+  m_storeGeneration = 0;
+  start();
+}
+
+pandamonium_kernel_writer::~pandamonium_kernel_writer()
+{
+  /*
+  ** Remaining operations are committed.
+  */
+
+  m_mutex.lock();
+  m_done = true;
+  m_condition.wakeOne();
+  m_mutex.unlock();
+  wait();
+}
+
+bool pandamonium_kernel_writer::isCongested(void)
+{
+  QMutexLocker locker(&m_mutex);
+
+  return m_queue.size() >= m_capacity;
+}
+
+int pandamonium_kernel_writer::size(void)
+{
+  QMutexLocker locker(&m_mutex);
+
+  return m_queue.size();
+}
+
+int pandamonium_kernel_writer::storeGeneration(void)
+{
+  QMutexLocker locker(&m_mutex);
+
+  return m_storeGeneration;
+}
+
+void pandamonium_kernel_writer::checkpoint(void)
+{
+  QMutexLocker locker(&m_mutex);
+
+  m_checkpoint = true;
+  m_condition.wakeOne();
+}
+
+void pandamonium_kernel_writer::commit
+(const QList<pandamonium_kernel_writer_operation> &list)
+{
+  if(list.isEmpty())
+    return;
+
+  QHash<QString, QPair<quint64, quint64> > hostStatistics;
+  QHash<QString, quint64> counters;
+  QHash<QString, quint64> gauges;
+  QMap<int, QPair<quint64, quint64> > statistics;
+  QStringList fileNames;
+
+  fileNames << "pandamonium_broken_urls.db"
+	    << "pandamonium_parsed_urls.db"
+	    << "pandamonium_statistics.db"
+	    << "pandamonium_visited_urls.db";
+
+  foreach(const QString &fileName, fileNames)
+    pandamonium_database::beginTransaction(fileName);
+
+  for(int i = 0; i < list.size(); i++)
+    {
+      const pandamonium_kernel_writer_operation &operation(list.at(i));
+
+      switch(operation.m_type)
+	{
+	case pandamonium_kernel_writer_operation::CompactVisitedUrls:
+	  {
+	    mergeVisitedUrls();
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::MarkUrlAsValidated:
+	  {
+	    pandamonium_database::markUrlAsValidated(operation.m_url);
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::MarkUrlAsVisited:
+	  {
+	    if(operation.m_visited &&
+	       m_store.contains(pandamonium_common::toEncoded(operation.m_url)))
+	      break;
+
+	    pandamonium_database::markUrlAsVisited
+	      (operation.m_url, operation.m_visited, operation.m_depth);
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::MarkUrlsAsModified:
+	  {
+	    pandamonium_database::markUrlsAsModified(operation.m_modified);
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::MarkUrlsAsUnvisited:
+	  {
+	    QList<QUrl> urls;
+
+	    for(int j = 0; j < operation.m_urls.size(); j++)
+	      if(!m_store.contains(pandamonium_common::
+				   toEncoded(operation.m_urls.at(j))))
+		urls << operation.m_urls.at(j);
+
+	    statistics[operation.m_depth].first +=
+	      pandamonium_database::markUrlsAsUnvisited
+	      (urls, operation.m_depth, operation.m_seed);
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::OpenUrlStore:
+	  {
+	    m_store.open();
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::RecordBrokenUrl:
+	  {
+	    pandamonium_database::recordBrokenUrl
+	      (operation.m_description, operation.m_url, operation.m_parentUrl);
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::SaveCounters:
+	  {
+	    QHashIterator<QString, quint64> it(operation.m_counters);
+
+	    while(it.hasNext())
+	      {
+		it.next();
+		counters[it.key()] += it.value();
+	      }
+
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::SaveDepthStatistics:
+	  {
+	    QMapIterator<int, QPair<quint64, quint64> >
+	      it(operation.m_statistics);
+
+	    while(it.hasNext())
+	      {
+		it.next();
+		statistics[it.key()].first += it.value().first;
+		statistics[it.key()].second += it.value().second;
+	      }
+
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::SaveGauges:
+	  {
+	    QHashIterator<QString, quint64> it(operation.m_counters);
+
+	    while(it.hasNext())
+	      {
+		it.next();
+		gauges[it.key()] = it.value();
+	      }
+
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::SaveHostStatistics:
+	  {
+	    QHashIterator<QString, QPair<quint64, quint64> >
+	      it(operation.m_hostStatistics);
+
+	    while(it.hasNext())
+	      {
+		it.next();
+		hostStatistics[it.key()].first += it.value().first;
+		hostStatistics[it.key()].second += it.value().second;
+	      }
+
+	    break;
+	  }
+	case pandamonium_kernel_writer_operation::SaveUrlMetaData:
+	  {
+	    pandamonium_database::saveUrlMetaData
+	      (operation.m_content,
+	       operation.m_contentHash,
+	       operation.m_etag,
+	       operation.m_lastModified,
+	       operation.m_description,
+	       operation.m_title,
+	       operation.m_url);
+	    break;
+	  }
+	default:
+	  break;
+	}
+    }
+
+  pandamonium_database::saveCounters(counters);
+  pandamonium_database::saveDepthStatistics(statistics);
+  pandamonium_database::saveGauges(gauges);
+  pandamonium_database::saveHostStatistics(hostStatistics);
+
+  foreach(const QString &fileName, fileNames)
+    pandamonium_database::endTransaction(fileName);
+}
+
+void pandamonium_kernel_writer::compactVisitedUrls(void)
+{
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_type = pandamonium_kernel_writer_operation::CompactVisitedUrls;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::enqueue
+(const pandamonium_kernel_writer_operation &operation)
+{
+  /*
+  ** The capacity is not enforced here. The fetches which are in
+  ** progress may complete while the queue is congested.
+  */
+
+  QMutexLocker locker(&m_mutex);
+
+  m_queue.enqueue(operation);
+
+  if(m_queue.size() == 1 || m_queue.size() >= m_batchSize)
+    m_condition.wakeOne();
+}
+
+void pandamonium_kernel_writer::markUrlAsValidated(const QUrl &url)
+{
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_type = pandamonium_kernel_writer_operation::MarkUrlAsValidated;
+  operation.m_url = url;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::markUrlAsVisited
+(const QUrl &url, const bool visited, const int depth)
+{
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_depth = depth;
+  operation.m_type = pandamonium_kernel_writer_operation::MarkUrlAsVisited;
+  operation.m_url = url;
+  operation.m_visited = visited;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::markUrlsAsModified
+(const QList<QPair<QUrl, qint64> > &list)
+{
+  if(list.isEmpty())
+    return;
+
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_modified = list;
+  operation.m_type = pandamonium_kernel_writer_operation::MarkUrlsAsModified;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::markUrlsAsUnvisited
+(const QList<QUrl> &urls, const int depth, const qint64 seed)
+{
+  if(urls.isEmpty())
+    return;
+
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_depth = depth;
+  operation.m_seed = seed;
+  operation.m_type = pandamonium_kernel_writer_operation::MarkUrlsAsUnvisited;
+  operation.m_urls = urls;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::mergeVisitedUrls(void)
+{
+  /*
+  ** Visited URLs are moved from pandamonium_visited_urls into the URL
+  ** store, pandamonium_url_store_batch rows at a time. The rows are
+  ** deleted within the current transaction after the store's new
+  ** segment has been synchronized. If the kernel terminates before
+  ** the transaction is committed, the rows are moved again and their
+  ** duplicate entries are discarded by a later merge of segments.
+  */
+
+  if(pandamonium_database::visitedUrlsCounts().second <
+     static_cast<quint64> (m_compactionBatch))
+    return;
+
+  QList<QList<QVariant> > list
+    (pandamonium_database::visitedUrls(m_compactionBatch));
+
+  if(list.size() < m_compactionBatch)
+    return;
+
+  QList<QPair<QByteArray, int> > urls;
+  QList<qint64> rowids;
+
+  for(int i = 0; i < list.size(); i++)
+    {
+      rowids << list.at(i).value(0).toLongLong();
+      urls << QPair<QByteArray, int> (list.at(i).value(1).toByteArray(),
+				      list.at(i).value(2).toInt());
+    }
+
+  if(!m_store.merge(urls))
+    return;
+
+  pandamonium_database::removeVisitedUrls(rowids);
+
+  QMutexLocker locker(&m_mutex);
+
+  m_storeGeneration += 1;
+}
+
+void pandamonium_kernel_writer::openUrlStore(void)
+{
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_type = pandamonium_kernel_writer_operation::OpenUrlStore;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::recordBrokenUrl(const QString &error_string,
+						const QUrl &child_url,
+						const QUrl &parent_url)
+{
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_description = error_string;
+  operation.m_parentUrl = parent_url;
+  operation.m_type = pandamonium_kernel_writer_operation::RecordBrokenUrl;
+  operation.m_url = child_url;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::run(void)
+{
+  m_store.open();
+
+  while(true)
+    {
+      QList<pandamonium_kernel_writer_operation> list;
+      bool checkpoint = false;
+      bool done = false;
+
+      m_mutex.lock();
+
+      if(m_queue.isEmpty() && !m_checkpoint && !m_done)
+	m_condition.wait(&m_mutex);
+
+      /*
+      ** Gather a group.
+      */
+
+      QElapsedTimer timer;
+
+      timer.start();
+
+      while(!m_done && !m_queue.isEmpty() && m_queue.size() < m_batchSize)
+	{
+	  qint64 remaining = m_interval - timer.elapsed();
+
+	  if(remaining <= 0)
+	    break;
+
+	  m_condition.wait(&m_mutex, static_cast<unsigned long> (remaining));
+	}
+
+      while(!m_queue.isEmpty() && list.size() < m_batchSize)
+	list << m_queue.dequeue();
+
+      checkpoint = m_checkpoint;
+      done = m_done && m_queue.isEmpty();
+      m_checkpoint = false;
+      m_mutex.unlock();
+      commit(list);
+
+      if(checkpoint)
+	pandamonium_database::checkpoint();
+
+      if(done)
+	break;
+    }
+}
+
+void pandamonium_kernel_writer::saveCounters
+(const QHash<QString, quint64> &counters)
+{
+  if(counters.isEmpty())
+    return;
+
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_counters = counters;
+  operation.m_type = pandamonium_kernel_writer_operation::SaveCounters;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::saveDepthStatistics
+(const QMap<int, QPair<quint64, quint64> > &statistics)
+{
+  if(statistics.isEmpty())
+    return;
+
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_statistics = statistics;
+  operation.m_type = pandamonium_kernel_writer_operation::SaveDepthStatistics;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::saveGauges
+(const QHash<QString, quint64> &gauges)
+{
+  if(gauges.isEmpty())
+    return;
+
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_counters = gauges;
+  operation.m_type = pandamonium_kernel_writer_operation::SaveGauges;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::saveHostStatistics
+(const QHash<QString, QPair<quint64, quint64> > &statistics)
+{
+  if(statistics.isEmpty())
+    return;
+
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_hostStatistics = statistics;
+  operation.m_type = pandamonium_kernel_writer_operation::SaveHostStatistics;
+  enqueue(operation);
+}
+
+void pandamonium_kernel_writer::saveUrlMetaData(const QByteArray &content,
+						const QByteArray &content_hash,
+						const QByteArray &etag,
+						const QByteArray &last_modified,
+						const QString &description,
+						const QString &title,
+						const QUrl &url)
+{
+  pandamonium_kernel_writer_operation operation;
+
+  operation.m_content = content;
+  operation.m_contentHash = content_hash;
+  operation.m_description = description;
+  operation.m_etag = etag;
+  operation.m_lastModified = last_modified;
+  operation.m_title = title;
+  operation.m_type = pandamonium_kernel_writer_operation::SaveUrlMetaData;
+  operation.m_url = url;
+  enqueue(operation);
+}
@@ -0,0 +1,157 @@
+/*
+** Copyright (c) Alexis Megas.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from pandamonium without specific prior written permission.
+**
+** pandamonium IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _pandamonium_kernel_writer_h_
+#define _pandamonium_kernel_writer_h_
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QThread>
+#include <QUrl>
+#include <QWaitCondition>
+
+#include "pandamonium-kernel-urlstore.h"
+
+class pandamonium_kernel_writer_operation
+{
+ public:
+  enum Types
+  {
+    CompactVisitedUrls = 0,
+    MarkUrlAsValidated,
+    MarkUrlAsVisited,
+    MarkUrlsAsModified,
+    MarkUrlsAsUnvisited,
+    OpenUrlStore,
+    RecordBrokenUrl,
+    SaveCounters,
+    SaveDepthStatistics,
+    SaveGauges,
+    SaveHostStatistics,
+    SaveUrlMetaData
+  };
+
+  pandamonium_kernel_writer_operation(void)
+  {
+    m_depth = 0;
+    m_seed = 0;
+    m_type = MarkUrlAsVisited;
+    m_visited = false;
+  }
+
+  QByteArray m_content;
+  QByteArray m_contentHash;
+  QByteArray m_etag;
+  QByteArray m_lastModified;
+  QHash<QString, QPair<quint64, quint64> > m_hostStatistics;
+  QHash<QString, quint64> m_counters; // Counters or gauges.
+  QList<QPair<QUrl, qint64> > m_modified;
+  QList<QUrl> m_urls;
+  QMap<int, QPair<quint64, quint64> > m_statistics;
+  QString m_description; // Also the error string of a broken URL.
+  QString m_title;
+  QUrl m_parentUrl;
+  QUrl m_url;
+  Types m_type;
+  bool m_visited;
+  int m_depth;
+  qint64 m_seed;
+};
+
+/*
+** Write-behind persistence. The kernel's thread places operations on a
+** bounded queue and never waits on the disk. The writer thread commits
+** the operations in groups, either every pandamonium_writer_interval
+** milliseconds or every pandamonium_writer_batch_size operations,
+** whichever occurs first. A full queue is reported via isCongested() so
+** that new fetches may be postponed.
+**
+** The writer also owns the URL store's merges. Visited URLs are moved
+** from pandamonium_visited_urls into the store on the writer's thread
+** and their rows are deleted after the store's new segment has been
+** synchronized. URLs which the writer's store contains are not written
+** to pandamonium_visited_urls. The kernel's copy of the store is
+** reopened whenever storeGeneration() changes.
+*/
+
+class pandamonium_kernel_writer: public QThread
+{
+ public:
+  pandamonium_kernel_writer(void);
+  ~pandamonium_kernel_writer();
+  bool isCongested(void);
+  int size(void);
+  int storeGeneration(void);
+  void checkpoint(void);
+  void compactVisitedUrls(void);
+  void markUrlAsValidated(const QUrl &url);
+  void markUrlAsVisited(const QUrl &url, const bool visited, const int depth);
+  void markUrlsAsModified(const QList<QPair<QUrl, qint64> > &list);
+  void markUrlsAsUnvisited(const QList<QUrl> &urls,
+			   const int depth,
+			   const qint64 seed);
+  void openUrlStore(void);
+  void recordBrokenUrl(const QString &error_string,
+		       const QUrl &child_url,
+		       const QUrl &parent_url);
+  void saveCounters(const QHash<QString, quint64> &counters);
+  void saveDepthStatistics
+    (const QMap<int, QPair<quint64, quint64> > &statistics);
+  void saveGauges(const QHash<QString, quint64> &gauges);
+  void saveHostStatistics
+    (const QHash<QString, QPair<quint64, quint64> > &statistics);
+  void saveUrlMetaData(const QByteArray &content,
+		       const QByteArray &content_hash,
+		       const QByteArray &etag,
+		       const QByteArray &last_modified,
+		       const QString &description,
+		       const QString &title,
+		       const QUrl &url);
+
+ private:
+  QMutex m_mutex;
+  QQueue<pandamonium_kernel_writer_operation> m_queue;
+  QWaitCondition m_condition;
+  bool m_checkpoint;
+  bool m_done;
+  int m_batchSize;
+  int m_capacity;
+  int m_compactionBatch;
+  int m_interval;
+  int m_storeGeneration;
+  pandamonium_kernel_urlstore m_store; // The writer's thread only.
+  void commit(const QList<pandamonium_kernel_writer_operation> &list);
+  void enqueue(const pandamonium_kernel_writer_operation &operation);
+  void mergeVisitedUrls(void);
+  void run(void);
+};
+
+#endif
@@ -25,8 +25,11 @@
 ** pandamonium, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <QApplication>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QNetworkAccessManager>
+#include <QSet>
+#include <QSettings>
 #include <QtDebug>
 
 #include "pandamonium-common.h"
@@ -38,8 +41,24 @@ static pandamonium_kernel *s_kernel = 0;
 pandamonium_kernel::pandamonium_kernel(void):QObject()
 {
   s_kernel = this;
+  m_frontierBlocked = false;
+  m_nextCompaction = 0;
+  m_nextRecrawl = 0;
+  m_recrawlCursor = QPair<qint64, qint64> (0, 0);
+  m_roundRobin = 0;
+  m_storeGeneration = 0;
   m_networkAccessManager = new QNetworkAccessManager(this);
   m_networkAccessManager->setProxy(pandamonium_common::proxy());
+  m_robots = new pandamonium_kernel_robots(this);
+  m_sitemap = new pandamonium_kernel_sitemap(this);
+  connect(m_robots,
+	  SIGNAL(sitemaps(const QString &, const QList<QUrl> &)),
+	  this,
+	  SLOT(slotSitemaps(const QString &, const QList<QUrl> &)));
+  connect(&m_checkpointTimer,
+	  SIGNAL(timeout(void)),
+	  this,
+	  SLOT(slotCheckpointTimeout(void)));
   connect(&m_controlTimer,
 	  SIGNAL(timeout(void)),
 	  this,
@@ -48,36 +67,442 @@ pandamonium_kernel::pandamonium_kernel(void):QObject()
 	  SIGNAL(timeout(void)),
 	  this,
 	  SLOT(slotRovingTimeout(void)));
+  connect(&m_scheduleTimer,
+	  SIGNAL(timeout(void)),
+	  this,
+	  SLOT(slotScheduleTimeout(void)));
+  m_checkpointTimer.start
+    (1000 * qBound(1,
+		   QSettings().value("pandamonium_sqlite_checkpoint_interval",
+				     30).toInt(),
+		   3600));
   m_controlTimer.start(2500);
   m_rovingTimer.start(2500);
+  m_scheduleTimer.start(50);
   pandamonium_database::createdb();
-  pandamonium_database::recordKernelProcessId(QApplication::applicationPid());
+  pandamonium_database::recordKernelProcessId(QCoreApplication::applicationPid());
+  m_store.open();
+  m_filter.rebuild(m_store);
+  m_frontier = new pandamonium_kernel_frontier();
+  m_writer = new pandamonium_kernel_writer();
 }
 
 pandamonium_kernel::~pandamonium_kernel()
 {
+  delete m_sitemap; // Remaining locations are queued.
   s_kernel = 0;
+  m_writer->saveDepthStatistics(m_depthStatistics);
+  m_writer->saveCounters(m_counters);
+  m_writer->saveHostStatistics(m_hostStatistics);
+  delete m_frontier;
+  delete m_writer; // Waits for the remaining operations.
+  m_filter.save(m_store);
   pandamonium_database::recordKernelDeactivation
-    (QApplication::applicationPid());
-  QApplication::quit();
+    (QCoreApplication::applicationPid());
+  QCoreApplication::quit();
+}
+
+QList<QUrl> pandamonium_kernel::canonicalize(const QList<QUrl> &urls)
+{
+  if(!s_kernel)
+    return urls;
+
+  /*
+  ** Rewritten URLs would have been distinct rows. Collapsed URLs are
+  ** distinct URLs which share canonical forms; each would have been
+  ** a separate frontier entry and fetch.
+  */
+
+  QList<QUrl> list;
+  QSet<QUrl> canonical;
+  QSet<QUrl> original;
+  quint64 rewritten = 0;
+
+  for(int i = 0; i < urls.size(); i++)
+    {
+      QUrl url(s_kernel->m_canonicalizer.canonicalize(urls.at(i)));
+
+      original.insert(urls.at(i));
+
+      if(url != urls.at(i))
+	rewritten += 1;
+
+      if(!canonical.contains(url))
+	{
+	  canonical.insert(url);
+	  list << url;
+	}
+    }
+
+  s_kernel->m_counters["canonical_collapsed"] += static_cast<quint64>
+    (original.size() - canonical.size());
+  s_kernel->m_counters["canonical_rewritten"] += rewritten;
+  return list;
 }
 
 QNetworkReply *pandamonium_kernel::get(const QNetworkRequest &request)
 {
   QNetworkRequest r(request);
 
+  /*
+  ** Qt does not decode the content if Accept-Encoding is set. The
+  ** decoding is performed by pandamonium_kernel_decoder.
+  */
+
   r.setRawHeader("Accept", "text/html");
+  r.setRawHeader
+    ("Accept-Encoding", pandamonium_kernel_decoder::acceptedEncodings());
   r.setRawHeader("User-Agent", "Pandamonium");
   return s_kernel->m_networkAccessManager->get(r);
 }
 
+QPointer<pandamonium_kernel_url> pandamonium_kernel::searchUrlOf
+(const pandamonium_frontier_entry &entry) const
+{
+  /*
+  ** The search URL which discovered the URL. Otherwise, a search URL
+  ** of the URL's host. Search URLs may have been removed and older rows
+  ** lack seeds.
+  */
+
+  QPointer<pandamonium_kernel_url> owner;
+  QString host(pandamonium_kernel_scheduler::hostOf(entry.m_url));
+
+  foreach(const QPointer<pandamonium_kernel_url> &u, m_searchUrls.values())
+    if(!u)
+      continue;
+    else if(entry.m_seed != 0 && u->seed() == entry.m_seed)
+      return u;
+    else if(!owner && pandamonium_kernel_scheduler::hostOf(u->url()) == host)
+      owner = u;
+
+  return owner;
+}
+
+bool pandamonium_kernel::isUrlDisallowed(const QUrl &url)
+{
+  if(s_kernel)
+    return s_kernel->m_robots->isDisallowed(url);
+  else
+    return false;
+}
+
+void pandamonium_kernel::markUrlAsValidated(const QUrl &url)
+{
+  if(s_kernel)
+    s_kernel->m_writer->markUrlAsValidated(url);
+}
+
+void pandamonium_kernel::markUrlAsVisited
+(const QUrl &url, const bool visited, const int depth)
+{
+  if(!s_kernel)
+    return;
+
+  /*
+  ** URLs which were moved into the URL store remain visited. They are
+  ** not returned to pandamonium_visited_urls.
+  */
+
+  QByteArray bytes(pandamonium_common::toEncoded(url));
+
+  s_kernel->m_attempts.remove(url);
+
+  if(!s_kernel->m_filter.insert(pandamonium_common::hash(bytes)))
+    if(visited && s_kernel->m_store.contains(bytes))
+      return;
+
+  s_kernel->m_writer->markUrlAsVisited(url, visited, depth);
+}
+
+void pandamonium_kernel::markUrlsAsModified
+(const QList<QPair<QUrl, qint64> > &list)
+{
+  if(s_kernel)
+    s_kernel->m_writer->markUrlsAsModified(list);
+}
+
+void pandamonium_kernel::markUrlsAsUnvisited
+(const QList<QUrl> &urls, const int depth, const qint64 seed)
+{
+  if(!s_kernel)
+    return;
+
+  /*
+  ** URLs which the filter does not contain are new. The others are
+  ** known or are false positives. URLs which are in the URL store are
+  ** known and are not offered to the writer. The remainder are offered
+  ** to pandamonium_visited_urls, which reads rather than writes the
+  ** rows of known URLs.
+  */
+
+  QList<QUrl> list;
+
+  for(int i = 0; i < urls.size(); i++)
+    {
+      QByteArray bytes(pandamonium_common::toEncoded(urls.at(i)));
+
+      if(s_kernel->m_filter.insert(pandamonium_common::hash(bytes)))
+	list << urls.at(i);
+      else if(!s_kernel->m_store.contains(bytes))
+	list << urls.at(i);
+    }
+
+  s_kernel->m_counters["filter_rejected"] += static_cast<quint64>
+    (urls.size() - list.size());
+  s_kernel->m_writer->markUrlsAsUnvisited(list, depth, seed);
+}
+
+void pandamonium_kernel::recordBrokenUrl(const QString &error_string,
+					 const QUrl &child_url,
+					 const QUrl &parent_url)
+{
+  if(s_kernel)
+    s_kernel->m_writer->recordBrokenUrl(error_string, child_url, parent_url);
+}
+
+void pandamonium_kernel::recordDepthStatistics(const int depth,
+					       const quint64 discovered,
+					       const quint64 fetched)
+{
+  if(!s_kernel)
+    return;
+
+  QPair<quint64, quint64> &pair(s_kernel->m_depthStatistics[qMax(0, depth)]);
+
+  pair.first += discovered;
+  pair.second += fetched;
+}
+
+void pandamonium_kernel::recordHostStatistics(const QString &host,
+					      const quint64 decoded,
+					      const quint64 wire)
+{
+  if(!s_kernel || host.isEmpty())
+    return;
+
+  QPair<quint64, quint64> &pair(s_kernel->m_hostStatistics[host]);
+
+  pair.first += decoded;
+  pair.second += wire;
+}
+
+void pandamonium_kernel::requeueUrl
+(const QUrl &url, const int depth, const qint64 seed)
+{
+  if(!s_kernel)
+    return;
+
+  /*
+  ** The URL's fetch was abandoned. Its row has passed the frontier's
+  ** cursor and will not be read again. URLs which are abandoned
+  ** repeatedly are recorded as broken.
+  */
+
+  int &attempts(s_kernel->m_attempts[url]);
+
+  attempts += 1;
+
+  if(attempts < s_maximumAttempts)
+    s_kernel->m_frontier->push(url, depth, seed);
+  else
+    {
+      s_kernel->m_writer->recordBrokenUrl
+	(QString("The URL was abandoned after %1 attempts.").
+	 arg(s_maximumAttempts),
+	 url,
+	 url);
+      markUrlAsVisited(url, true, depth);
+    }
+}
+
+void pandamonium_kernel::saveUrlMetaData(const QByteArray &content,
+					 const QByteArray &content_hash,
+					 const QByteArray &etag,
+					 const QByteArray &last_modified,
+					 const QString &description,
+					 const QString &title,
+					 const QUrl &url)
+{
+  if(s_kernel)
+    s_kernel->m_writer->saveUrlMetaData
+      (content, content_hash, etag, last_modified, description, title, url);
+}
+
+void pandamonium_kernel::slotCheckpointTimeout(void)
+{
+  m_writer->checkpoint();
+}
+
 void pandamonium_kernel::slotControlTimeout(void)
 {
+  /*
+  ** The interface may have removed some of the databases.
+  */
+
+  if(pandamonium_database::invalidateReplacedDatabases())
+    {
+      pandamonium_database::createdb();
+      m_store.open();
+      m_filter.rebuild(m_store);
+      m_writer->openUrlStore();
+
+      /*
+      ** The frontier's cursors and the scheduler's URLs describe the
+      ** previous pandamonium_visited_urls.
+      */
+
+      m_attempts.clear();
+      m_frontier->reset();
+      m_frontierBlocked = false;
+      m_nextRecrawl = 0;
+      m_recrawlCursor = QPair<qint64, qint64> (0, 0);
+      m_scheduler.reset();
+      m_validators.clear();
+    }
+  else if(m_filter.isSaturated())
+    m_filter.rebuild(m_store);
+
   if(pandamonium_database::
-     shouldTerminateKernel(QApplication::applicationPid()))
+     shouldTerminateKernel(QCoreApplication::applicationPid()))
     deleteLater();
 
+  m_writer->saveDepthStatistics(m_depthStatistics);
+  m_depthStatistics.clear();
+  m_writer->saveCounters(m_counters);
+  m_counters.clear();
+
+  QHash<QString, quint64> gauges;
+
+  gauges["filter_false_positive_ppm"] = static_cast<quint64>
+    (1000000.0 * m_filter.falsePositiveRate() + 0.5);
+  gauges["url_store_bytes"] = static_cast<quint64> (m_store.bytes());
+  gauges["url_store_urls"] = m_store.size();
+  m_writer->saveGauges(gauges);
+  m_writer->saveHostStatistics(m_hostStatistics);
+  m_hostStatistics.clear();
+
   m_networkAccessManager->setProxy(pandamonium_common::proxy());
+  m_robots->prune(QDateTime::currentMSecsSinceEpoch());
+  m_sitemap->prune(QDateTime::currentMSecsSinceEpoch());
+  m_scheduler.prune(QDateTime::currentMSecsSinceEpoch());
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  if(m_nextCompaction <= now)
+    {
+      m_writer->compactVisitedUrls();
+      m_nextCompaction = now + 60000;
+    }
+
+  /*
+  ** The writer has merged visited URLs into the URL store.
+  */
+
+  if(m_storeGeneration != m_writer->storeGeneration())
+    {
+      m_storeGeneration = m_writer->storeGeneration();
+      m_store.open();
+    }
+}
+
+void pandamonium_kernel::refillScheduler(const qint64 now)
+{
+  m_frontier->refill(now);
+
+  /*
+  ** URLs whose hosts have saturated queues are parked with the
+  ** scheduler. If the hosts' overflows are also saturated, the URLs are
+  ** deferred to the frontier's spill segment. A pass which places
+  ** nothing with the scheduler suspends the transfer until a URL is
+  ** dispatched.
+  */
+
+  if(!m_frontierBlocked)
+    {
+      bool placed = false;
+      int count = m_frontier->size();
+      int deferrals = 0;
+
+      while(count-- > 0 && m_scheduler.size() < s_schedulerCapacity)
+	{
+	  pandamonium_frontier_entry entry(m_frontier->pop());
+
+	  if(!m_scheduler.isHostFull(entry.m_url))
+	    {
+	      deferrals = 0;
+	      m_scheduler.enqueue(entry);
+	      placed = true;
+	    }
+	  else if(m_scheduler.park(entry))
+	    {
+	      deferrals = 0;
+	      placed = true;
+	    }
+	  else
+	    {
+	      m_frontier->defer(entry.m_url, entry.m_depth, entry.m_seed);
+
+	      if(++deferrals >= s_maximumDeferrals)
+		break;
+	    }
+	}
+
+      m_frontierBlocked = !placed && !m_frontier->isEmpty();
+    }
+
+  if(m_scheduler.size() > 0 || !m_frontier->isEmpty() ||
+     m_frontier->spilled() > 0 || m_writer->size() > 0)
+    return;
+
+  /*
+  ** Nothing remains. Revisit the parsed URLs which are due, the
+  ** stalest first. Search URLs which have not been parsed are
+  ** restarted.
+  */
+
+  if(now < m_nextRecrawl)
+    return;
+
+  QList<QList<QVariant> > list
+    (pandamonium_database::dueUrls(now / 1000,
+				   m_recrawlCursor,
+				   s_schedulerCapacity));
+
+  m_nextRecrawl = now + 1000;
+
+  while(!list.isEmpty())
+    {
+      QList<QVariant> values(list.takeFirst()); /*
+						** 0 - url
+						** 1 - depth
+						** 2 - etag
+						** 3 - last_modified
+						** 4 - seed
+						*/
+      QUrl url(values.value(0).toUrl());
+      int depth = values.value(1).toInt();
+
+      if(depth < 0)
+	depth = qMax(0, m_store.depth(pandamonium_common::toEncoded(url)));
+
+      /*
+      ** The validators are retained until the URL is dispatched.
+      */
+
+      if(!values.value(2).toByteArray().isEmpty() ||
+	 !values.value(3).toByteArray().isEmpty())
+	m_validators[url] = QPair<QByteArray, QByteArray>
+	  (values.value(2).toByteArray(), values.value(3).toByteArray());
+
+      m_frontier->push(url, depth, values.value(4).toLongLong());
+    }
+
+  foreach(const QPointer<pandamonium_kernel_url> &u, m_searchUrls.values())
+    if(u && u->hasCapacity() && u->isIdle())
+      if(!pandamonium_database::isUrlParsed(u->url()))
+	m_scheduler.enqueue
+	  (pandamonium_frontier_entry(u->url(), 0, u->seed()));
 }
 
 void pandamonium_kernel::slotRovingTimeout(void)
@@ -88,12 +513,15 @@ void pandamonium_kernel::slotRovingTimeout(void)
   for(int i = 0; i < list.size(); i++)
     {
       QList<QVariant> values(list.at(i)); /*
-					  ** 0 - paused
-					  ** 1 - request_interval
-					  ** 2 - search_depth
-					  ** 3 - url
+					  ** 0 - concurrency
+					  ** 1 - head_only
+					  ** 2 - meta_data_only
+					  ** 3 - paused
+					  ** 4 - request_interval
+					  ** 5 - search_depth
+					  ** 6 - url
 					  */
-      QUrl url(values.value(3).toUrl());
+      QUrl url(values.value(6).toUrl());
 
       if(url.isEmpty())
 	continue;
@@ -106,12 +534,18 @@ void pandamonium_kernel::slotRovingTimeout(void)
 	{
 	  QPointer<pandamonium_kernel_url> u = new pandamonium_kernel_url
 	    (url,
-	     values.value(0).toBool(),
-	     values.value(1).toDouble(),
-	     values.value(2).toInt(),
+	     values.value(3).toBool(),
+	     values.value(4).toDouble(),
+	     values.value(0).toInt(),
+	     values.value(5).toInt(),
 	     this);
 
 	  m_searchUrls[url] = u;
+	  u->setHeadOnly(values.value(1).toBool());
+	  u->setMetaDataOnly(values.value(2).toBool());
+
+	  if(u->hasCapacity())
+	    m_frontier->push(url, 0, u->seed());
 	}
       else
 	{
@@ -119,8 +553,12 @@ void pandamonium_kernel::slotRovingTimeout(void)
 
 	  if(u)
 	    {
-	      u->setPaused(values.value(0).toBool());
-	      u->setRequestInterval(values.value(1).toDouble());
+	      u->setConcurrency(values.value(0).toInt());
+	      u->setHeadOnly(values.value(1).toBool());
+	      u->setMetaDataOnly(values.value(2).toBool());
+	      u->setPaused(values.value(3).toBool());
+	      u->setRequestInterval(values.value(4).toDouble());
+	      u->setSearchDepth(values.value(5).toInt());
 	    }
 	}
     }
@@ -143,3 +581,133 @@ void pandamonium_kernel::slotRovingTimeout(void)
 	}
     }
 }
+
+void pandamonium_kernel::slotScheduleTimeout(void)
+{
+  /*
+  ** New fetches are postponed while the writer is congested.
+  */
+
+  if(m_writer->isCongested())
+    return;
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  refillScheduler(now);
+
+  QList<QPointer<pandamonium_kernel_url> > list(m_searchUrls.values());
+
+  if(list.isEmpty())
+    return;
+
+  /*
+  ** URLs are dispatched to the search URLs which discovered them so
+  ** that the search URLs' depths and modes apply. URLs whose search URLs
+  ** lack capacity are postponed. URLs without search URLs are issued to
+  ** the search URLs in a round-robin fashion.
+  */
+
+  m_roundRobin = (m_roundRobin + 1) % list.size();
+
+  while(m_scheduler.isReady(now))
+    {
+      bool capacity = false;
+
+      for(int i = 0; i < list.size(); i++)
+	if(list.at(i) && list.at(i)->hasCapacity())
+	  {
+	    capacity = true;
+	    break;
+	  }
+
+      if(!capacity)
+	break;
+
+      pandamonium_frontier_entry entry(m_scheduler.dequeue(now, 0));
+
+      if(entry.m_url.isEmpty())
+	break;
+
+      m_frontierBlocked = false;
+
+      /*
+      ** URLs whose origins have pending robots.txt files are
+      ** postponed. Disallowed URLs are not fetched.
+      */
+
+      QString host(pandamonium_kernel_scheduler::hostOf(entry.m_url));
+
+      switch(m_robots->state(entry.m_url))
+	{
+	case pandamonium_kernel_robots::Disallowed:
+	  {
+	    m_validators.remove(entry.m_url);
+	    markUrlAsVisited(entry.m_url, true, entry.m_depth);
+	    continue;
+	  }
+	case pandamonium_kernel_robots::Pending:
+	  {
+	    m_scheduler.setHostDelay(host, now + 1000);
+	    m_scheduler.enqueue(entry);
+	    continue;
+	  }
+	default:
+	  break;
+	}
+
+      QPointer<pandamonium_kernel_url> u(searchUrlOf(entry));
+
+      if(!u)
+	for(int i = 0; i < list.size(); i++)
+	  {
+	    QPointer<pandamonium_kernel_url> v
+	      (list.at((m_roundRobin + i) % list.size()));
+
+	    if(v && v->hasCapacity())
+	      {
+		m_roundRobin = (m_roundRobin + i + 1) % list.size();
+		u = v;
+		break;
+	      }
+	  }
+
+      qint64 interval = u ?
+	static_cast<qint64> (1000 * u->requestInterval()) : 1000;
+
+      if(!u || !u->hasCapacity())
+	{
+	  m_scheduler.setHostDelay(host, now + interval);
+	  m_scheduler.enqueue(entry);
+	  continue;
+	}
+
+      qint64 delay = m_robots->crawlDelay(entry.m_url);
+
+      m_scheduler.setCrawlDelay(host, delay);
+      m_scheduler.setHostDelay(host, now + qMax(delay, interval));
+      u->load(entry.m_url, entry.m_depth, m_validators.take(entry.m_url));
+    }
+}
+
+void pandamonium_kernel::slotSitemaps
+(const QString &origin, const QList<QUrl> &urls)
+{
+  /*
+  ** Sitemaps are read for the origins of search URLs whose links are
+  ** followed. Origins which do not list sitemaps are offered
+  ** /sitemap.xml.
+  */
+
+  foreach(const QPointer<pandamonium_kernel_url> &u, m_searchUrls.values())
+    if(u && u->searchDepth() != 0)
+      if(pandamonium_kernel_robots::originOf(u->url()) == origin)
+	{
+	  if(urls.isEmpty())
+	    m_sitemap->load(QUrl(origin + "/sitemap.xml"), u->url().host());
+	  else
+	    foreach(const QUrl &url, urls)
+	      m_sitemap->load(url, u->url().host());
+
+	  break;
+	}
+}
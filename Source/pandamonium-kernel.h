@@ -29,6 +29,7 @@
 #define _pandamonium_kernel_h_
 
 #include <QHash>
+#include <QMap>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
@@ -36,7 +37,15 @@
 #include <QPointer>
 #include <QTimer>
 
+#include "pandamonium-kernel-canonicalizer.h"
+#include "pandamonium-kernel-filter.h"
+#include "pandamonium-kernel-frontier.h"
+#include "pandamonium-kernel-robots.h"
+#include "pandamonium-kernel-scheduler.h"
+#include "pandamonium-kernel-sitemap.h"
 #include "pandamonium-kernel-url.h"
+#include "pandamonium-kernel-urlstore.h"
+#include "pandamonium-kernel-writer.h"
 
 class QNetworkAccessManager;
 
@@ -47,17 +56,76 @@ class pandamonium_kernel: public QObject
  public:
   pandamonium_kernel(void);
   ~pandamonium_kernel();
+  static QList<QUrl> canonicalize(const QList<QUrl> &urls);
   static QNetworkReply *get(const QNetworkRequest &request);
+  static bool isUrlDisallowed(const QUrl &url);
+  static void markUrlAsValidated(const QUrl &url);
+  static void markUrlAsVisited(const QUrl &url,
+			       const bool visited,
+			       const int depth);
+  static void markUrlsAsModified(const QList<QPair<QUrl, qint64> > &list);
+  static void markUrlsAsUnvisited(const QList<QUrl> &urls,
+				  const int depth,
+				  const qint64 seed);
+  static void recordBrokenUrl(const QString &error_string,
+			      const QUrl &child_url,
+			      const QUrl &parent_url);
+  static void recordDepthStatistics(const int depth,
+				    const quint64 discovered,
+				    const quint64 fetched);
+  static void recordHostStatistics(const QString &host,
+				   const quint64 decoded,
+				   const quint64 wire);
+  static void requeueUrl(const QUrl &url,
+			 const int depth,
+			 const qint64 seed);
+  static void saveUrlMetaData(const QByteArray &content,
+			      const QByteArray &content_hash,
+			      const QByteArray &etag,
+			      const QByteArray &last_modified,
+			      const QString &description,
+			      const QString &title,
+			      const QUrl &url);
 
  private:
+  QHash<QString, QPair<quint64, quint64> > m_hostStatistics;
+  QHash<QString, quint64> m_counters;
   QHash<QUrl, QPointer<pandamonium_kernel_url> > m_searchUrls;
+  QHash<QUrl, QPair<QByteArray, QByteArray> > m_validators;
+  QHash<QUrl, int> m_attempts;
+  QMap<int, QPair<quint64, quint64> > m_depthStatistics;
   QNetworkAccessManager *m_networkAccessManager;
+  QPair<qint64, qint64> m_recrawlCursor;
+  QTimer m_checkpointTimer;
   QTimer m_controlTimer;
   QTimer m_rovingTimer;
+  QTimer m_scheduleTimer;
+  bool m_frontierBlocked;
+  int m_roundRobin;
+  int m_storeGeneration;
+  qint64 m_nextCompaction;
+  qint64 m_nextRecrawl;
+  pandamonium_kernel_canonicalizer m_canonicalizer;
+  pandamonium_kernel_filter m_filter;
+  pandamonium_kernel_frontier *m_frontier;
+  pandamonium_kernel_robots *m_robots;
+  pandamonium_kernel_scheduler m_scheduler;
+  pandamonium_kernel_sitemap *m_sitemap;
+  pandamonium_kernel_urlstore m_store;
+  pandamonium_kernel_writer *m_writer;
+  static const int s_maximumAttempts = 3;
+  static const int s_maximumDeferrals = 64;
+  static const int s_schedulerCapacity = 2048;
+  QPointer<pandamonium_kernel_url> searchUrlOf
+    (const pandamonium_frontier_entry &entry) const;
+  void refillScheduler(const qint64 now);
 
  private slots:
+  void slotCheckpointTimeout(void);
   void slotControlTimeout(void);
   void slotRovingTimeout(void);
+  void slotScheduleTimeout(void);
+  void slotSitemaps(const QString &origin, const QList<QUrl> &urls);
 };
 
 #endif
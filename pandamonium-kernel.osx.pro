@@ -1,6 +1,7 @@
-CONFIG += qt release warn_on
+CONFIG += qt release thread warn_on
 LANGUAGE = C++
-QT += network sql widgets
+QT += network sql
+QT -= gui
 TEMPLATE = app
 
 QMAKE_CLEAN += pandamonium-kernel
@@ -17,16 +18,48 @@ QMAKE_CXXFLAGS_RELEASE += -Wall \
                           -fstack-protector-all \
                           -fwrapv
 
+brotli {
+DEFINES += PANDAMONIUM_BROTLI
+LIBS += -lbrotlidec
+}
+
+benchmark_qtextdocument {
+DEFINES += PANDAMONIUM_BENCHMARK_QTEXTDOCUMENT
+QT += gui
+}
+
 INCLUDEPATH += . Source
-LIBS += -framework Cocoa
+LIBS += -framework Cocoa -lz
 HEADERS = Source/pandamonium-common.h \
 	  Source/pandamonium-database.h \
           Source/pandamonium-kernel.h \
-          Source/pandamonium-kernel-url.h
+          Source/pandamonium-kernel-canonicalizer.h \
+          Source/pandamonium-kernel-decoder.h \
+          Source/pandamonium-kernel-filter.h \
+          Source/pandamonium-kernel-frontier.h \
+          Source/pandamonium-kernel-parser.h \
+          Source/pandamonium-kernel-robots.h \
+          Source/pandamonium-kernel-scanner.h \
+          Source/pandamonium-kernel-scheduler.h \
+          Source/pandamonium-kernel-sitemap.h \
+          Source/pandamonium-kernel-url.h \
+          Source/pandamonium-kernel-urlstore.h \
+          Source/pandamonium-kernel-writer.h
 SOURCES = Source/pandamonium-database.cc \
           Source/pandamonium-kernel.cc \
+          Source/pandamonium-kernel-canonicalizer.cc \
+          Source/pandamonium-kernel-decoder.cc \
+          Source/pandamonium-kernel-filter.cc \
+          Source/pandamonium-kernel-frontier.cc \
+          Source/pandamonium-kernel-parser.cc \
+          Source/pandamonium-kernel-robots.cc \
+          Source/pandamonium-kernel-scanner.cc \
 	  Source/pandamonium-kernel-main.cc \
-          Source/pandamonium-kernel-url.cc
+          Source/pandamonium-kernel-scheduler.cc \
+          Source/pandamonium-kernel-sitemap.cc \
+          Source/pandamonium-kernel-url.cc \
+          Source/pandamonium-kernel-urlstore.cc \
+          Source/pandamonium-kernel-writer.cc
 
 OBJECTIVE_HEADERS += Source/CocoaInitializer.h
 OBJECTIVE_SOURCES += Source/CocoaInitializer.mm